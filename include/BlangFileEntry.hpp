@@ -26,12 +26,12 @@ class BlangFileEntry
 {
 public:
     class BlangFile BlangFile;
-    ResourceChunk Chunk;
+    size_t Chunk{0};
     bool WasModified{false};
     bool Announce{false};
 
     BlangFileEntry() {}
-    BlangFileEntry(class BlangFile blangFile, ResourceChunk chunk) : BlangFile(blangFile), Chunk(chunk) {}
+    BlangFileEntry(class BlangFile blangFile, size_t chunk) : BlangFile(blangFile), Chunk(chunk) {}
 };
 
 #endif
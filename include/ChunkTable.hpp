@@ -0,0 +1,51 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHUNKTABLE_HPP
+#define CHUNKTABLE_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// A container's chunks as a structure of arrays, indexed by chunk
+class ChunkTable
+{
+public:
+    std::vector<uint64_t> FileOffsets; // Position of the chunk's data offset in the container, followed by its sizes
+    std::vector<uint64_t> SizesZ;
+    std::vector<uint64_t> Sizes;
+    std::vector<std::byte> CompressionModes;
+    std::vector<size_t> NameIds;
+
+    size_t size() const { return NameIds.size(); }
+    bool empty() const { return NameIds.empty(); }
+
+    void resize(const size_t count)
+    {
+        FileOffsets.resize(count);
+        SizesZ.resize(count);
+        Sizes.resize(count);
+        CompressionModes.resize(count);
+        NameIds.resize(count);
+    }
+
+    uint64_t SizeOffset(const size_t chunk) const { return FileOffsets[chunk] + 8; }
+};
+
+#endif
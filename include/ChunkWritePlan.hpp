@@ -0,0 +1,99 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CHUNKWRITEPLAN_HPP
+#define CHUNKWRITEPLAN_HPP
+
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "MemoryMappedFile.hpp"
+#include "ResourceContainer.hpp"
+#include "ThreadPool.hpp"
+
+// Source of a part of the container being rewritten in slow mode
+enum SegmentSource
+{
+    ContainerSegment,   // Bytes the container had when the plan started
+    DataSegment         // Planned mod data
+};
+
+// Mod data written into a container's chunks, planned first and written all at once
+// Fast mode appends the data at the end of the container, resizing it once
+// Slow mode replaces the data in place, rewriting the container in one pass that moves every byte to its final position,
+// so the container grows or shrinks by exactly the size difference of the replaced data
+class ChunkWritePlan
+{
+public:
+    ChunkWritePlan(MemoryMappedFile& containerFile, ResourceContainer& container, ThreadPool *threadPool)
+        : ContainerFile(containerFile), Container(container), Pool(threadPool) {}
+
+    bool empty() const { return Writes.empty(); }
+
+    bool Add(const size_t chunk, ResourceModFile& modFile, const uint64_t compressedSize, const uint64_t uncompressedSize, const std::byte *compressionMode);
+    size_t Write(std::stringstream& os, std::vector<size_t>& failedChunks);
+private:
+    class PlannedWrite
+    {
+    public:
+        size_t Chunk;
+        std::string Name;
+        ModFileBytes FileBytes;
+        uint64_t CompressedSize;
+        uint64_t UncompressedSize;
+        std::optional<std::byte> CompressionMode;
+        uint64_t DataOffset{0};
+        bool Written{false};
+    };
+
+    class Segment
+    {
+    public:
+        SegmentSource Source;
+        uint64_t Offset;    // Offset in the original container or in the planned data
+        uint64_t Length;
+        size_t WriteIndex{0};   // Planned write holding the data
+    };
+
+    MemoryMappedFile& ContainerFile;
+    ResourceContainer& Container;
+    ThreadPool *Pool;
+    std::vector<PlannedWrite> Writes;
+
+    // Slow mode layout of the rewritten container, and the chunk fields it changes
+    std::vector<Segment> Segments;
+    uint64_t PlannedSize{0};
+    std::vector<std::pair<size_t, int64_t>> OffsetShifts;   // Chunks resized, and how much the chunks after them move
+    std::map<size_t, uint64_t> PlannedSizesZ;
+
+    uint64_t ReadField(const uint64_t position) const;
+    void WriteField(const uint64_t position, const uint64_t value);
+
+    bool PlanInPlace(const size_t chunk, const uint64_t dataSize, const uint64_t compressedSize);
+    void Splice(const uint64_t position, const uint64_t length, const std::vector<Segment>& replacement);
+    void WriteAtEnd();
+    void WriteInPlace();
+
+    static void CopyRange(std::byte *containerData, std::vector<PlannedWrite>& writes, const size_t begin, const size_t end);
+};
+
+#endif
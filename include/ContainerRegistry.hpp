@@ -0,0 +1,141 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONTAINERREGISTRY_HPP
+#define CONTAINERREGISTRY_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+// Containers used by mods, looked up by name from several threads
+// Lookups are lock-free, only adding a container takes the lock
+template<class Container>
+class ContainerRegistry
+{
+public:
+    ContainerRegistry()
+    {
+        Tables.push_back(std::make_unique<IndexTable>(64));
+        Index = Tables.back().get();
+    }
+
+    // Get the container with the given name, nullptr if it hasn't been added
+    Container *Find(const std::string& name) const
+    {
+        IndexTable *table = Index.load(std::memory_order_acquire);
+
+        for (size_t i = std::hash<std::string>()(name) & table->Mask;; i = (i + 1) & table->Mask) {
+            Container *container = table->Slots[i].load(std::memory_order_acquire);
+
+            if (container == nullptr || container->Name == name) {
+                return container;
+            }
+        }
+    }
+
+    // Get the container with the given name, adding it if needed
+    Container& GetOrAdd(const std::string& name, const std::string& path)
+    {
+        Container *container = Find(name);
+
+        if (container != nullptr) {
+            return *container;
+        }
+
+        std::lock_guard<std::mutex> lock(Mutex);
+
+        // Another thread might have added it in the meantime
+        container = Find(name);
+
+        if (container != nullptr) {
+            return *container;
+        }
+
+        Containers.emplace_back(name, path);
+        container = &Containers.back();
+
+        // Keep the table at most half full, old tables stay alive for concurrent readers
+        IndexTable *table = Index.load(std::memory_order_relaxed);
+
+        if (Containers.size() * 2 > table->Mask + 1) {
+            Tables.push_back(std::make_unique<IndexTable>((table->Mask + 1) * 2));
+            table = Tables.back().get();
+
+            for (auto& existingContainer : Containers) {
+                Insert(*table, existingContainer);
+            }
+
+            Index.store(table, std::memory_order_release);
+        }
+        else {
+            Insert(*table, *container);
+        }
+
+        return *container;
+    }
+
+    // Move the containers out in the order they were added, once no other thread uses the registry
+    std::vector<Container> TakeContainers()
+    {
+        std::vector<Container> containers(std::make_move_iterator(Containers.begin()), std::make_move_iterator(Containers.end()));
+        Containers.clear();
+
+        Tables.clear();
+        Tables.push_back(std::make_unique<IndexTable>(64));
+        Index = Tables.back().get();
+
+        return containers;
+    }
+private:
+    class IndexTable
+    {
+    public:
+        size_t Mask;
+        std::unique_ptr<std::atomic<Container*>[]> Slots;
+
+        IndexTable(size_t capacity) : Mask(capacity - 1), Slots(std::make_unique<std::atomic<Container*>[]>(capacity))
+        {
+            for (size_t i = 0; i < capacity; i++) {
+                Slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::deque<Container> Containers;
+    std::vector<std::unique_ptr<IndexTable>> Tables;
+    std::atomic<IndexTable*> Index{nullptr};
+    std::mutex Mutex;
+
+    static void Insert(IndexTable& table, Container& container)
+    {
+        size_t i = std::hash<std::string>()(container.Name) & table.Mask;
+
+        while (table.Slots[i].load(std::memory_order_relaxed) != nullptr) {
+            i = (i + 1) & table.Mask;
+        }
+
+        table.Slots[i].store(&container, std::memory_order_release);
+    }
+};
+
+#endif
@@ -19,16 +19,11 @@
 #ifndef GETOBJECT_HPP
 #define GETOBJECT_HPP
 
-#include <string>
+#include <string_view>
 #include "ProgramOptions.hpp"
 #include "ResourceContainer.hpp"
-#include "SoundContainer.hpp"
 
-// Get container index
-ssize_t GetResourceContainer(const std::string& resourceContainerName, std::vector<ResourceContainer>& resourceContainerList);
-ssize_t GetSoundContainer(const std::string& soundContainerName, std::vector<SoundContainer>& soundContainerList);
-
-// Get chunk in a container
-ResourceChunk *GetChunk(const std::string name, ResourceContainer& resourceContainer);
+// Get the index of a chunk in a container, or -1 if it isn't found
+ssize_t GetChunk(const std::string_view name, const ResourceContainer& resourceContainer);
 
 #endif
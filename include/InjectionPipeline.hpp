@@ -0,0 +1,62 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef INJECTIONPIPELINE_HPP
+#define INJECTIONPIPELINE_HPP
+
+#include <string>
+#include <set>
+#include <map>
+#include <mutex>
+#include <functional>
+#include "ContainerRegistry.hpp"
+#include "ResourceContainer.hpp"
+#include "ResourceData.hpp"
+#include "SoundContainer.hpp"
+#include "ThreadPool.hpp"
+
+// Starts injecting each container on the pool as soon as every mod loading files into it is done,
+// while the other mods are still loading
+class InjectionPipeline
+{
+public:
+    // Containers that must wait until all mods are loaded anyway
+    std::function<bool(const ResourceContainer&)> HoldBack;
+
+    InjectionPipeline(ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+        std::map<uint64_t, ResourceDataEntry>& resourceDataMap, ThreadPool *threadPool)
+        : ResourceContainers(resourceContainers), SoundContainers(soundContainers), ResourceDataMap(resourceDataMap), Pool(threadPool) {}
+
+    void AddSource(const std::set<std::string>& containerNames);
+    void SourceLoaded(const std::set<std::string>& containerNames);
+    void Wait();
+
+    bool WasStarted(const std::string& containerName) const { return StartedContainers.count(containerName) != 0; }
+private:
+    ContainerRegistry<ResourceContainer>& ResourceContainers;
+    ContainerRegistry<SoundContainer>& SoundContainers;
+    std::map<uint64_t, ResourceDataEntry>& ResourceDataMap;
+    ThreadPool *Pool;
+
+    std::mutex Mutex;
+    std::map<std::string, size_t> PendingSources;
+    std::set<std::string> StartedContainers;
+    TaskGroup InjectionTasks;
+};
+
+#endif
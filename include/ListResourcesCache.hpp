@@ -0,0 +1,94 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISTRESOURCESCACHE_HPP
+#define LISTRESOURCESCACHE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <set>
+#include <mutex>
+#include <cstdint>
+
+#define LIST_RESOURCES_CACHE_VERSION 1
+
+// Archive container flags
+enum ArchiveContainerFlags : uint32_t
+{
+    RedirectableArchiveContainer = 1 << 0,  // Files follow --redirectBlangContainer
+    AssetsInfoArchiveContainer = 1 << 1,    // Has assets info JSONs
+    ModifiesMapsArchiveContainer = 1 << 2,  // Assets info with assets, layers or maps
+    ModifiesResourcesArchiveContainer = 1 << 3  // Assets info with resources
+};
+
+// What --list-res needs to know about the files a zipped mod loads into a container
+class ArchiveContainer
+{
+public:
+    std::string ResourceName;
+    uint32_t Flags{0};
+    std::string ModFileName;        // A mod file loaded into the container, empty if there's none
+    std::string UnsafeModFileName;  // A mod file unsafe for online in unsafe containers, empty if there's none
+};
+
+// A zipped mod's containers, valid while the archive's size, write time and central directory are unchanged
+class ArchiveSummary
+{
+public:
+    uint64_t Size{0};
+    int64_t WriteTime{0};
+    uint32_t CentralDirectoryCrc{0};
+    std::vector<ArchiveContainer> Containers;
+};
+
+// What the zipped mods listed from their summaries load into a resource container
+class ListedResourceContainer
+{
+public:
+    bool HasModFiles{false};            // Has files other than assets info JSONs
+    bool HasOnlyDisablerFiles{true};    // Those files are named like the multiplayer disabler's, which replaces them
+    bool ModifiesMaps{false};           // Has assets info with assets, layers or maps
+};
+
+// The resource containers zipped mods were listed into, instead of loading their files
+class ListedResources
+{
+public:
+    std::map<std::string, ListedResourceContainer> ResourceContainers;
+    bool ModifiesPackageMapSpec{false}; // Has assets info with resources
+};
+
+// Per-archive summaries kept between --list-res runs, so unchanged zips are only checked, not read
+class ListResourcesCache
+{
+public:
+    ListResourcesCache(const std::string& cachePath);
+
+    std::optional<ArchiveSummary> GetSummary(const std::string& zippedMod);
+    bool Save();
+private:
+    std::string CachePath;
+    std::mutex Mutex;
+    std::map<std::string, ArchiveSummary> Summaries;
+    std::set<std::string> UsedArchives;
+    bool Modified{false};
+};
+
+#endif
@@ -20,22 +20,60 @@
 #define LOADMODFILES_HPP
 
 #include <map>
-#include <atomic>
+#include <optional>
+#include <set>
 #include "ResourceContainer.hpp"
 #include "SoundContainer.hpp"
 #include "StreamDBContainer.hpp"
+#include "ThreadPool.hpp"
+#include "ContainerRegistry.hpp"
+#include "ListResourcesCache.hpp"
 
-// Load zipped mods into container list
-void LoadZippedMod(std::string zippedMod,
-    std::vector<ResourceContainer>& resourceContainerList, std::vector<SoundContainer>& soundContainerList,
-    std::vector<StreamDBContainer>& streamDBContainerList, std::vector<std::string>& notFoundContainers);
-
-// Load loose mods into container list
-void LoadUnzippedMod(std::string unzippedMod, Mod& globalLooseMod, std::atomic<size_t>& unzippedModCount,
-    std::map<size_t, std::vector<ResourceModFile>>& resourceModFiles,
-    std::map<size_t, std::vector<SoundModFile>>& soundModFiles,
-    std::map<size_t, std::vector<StreamDBModFile>>& streamDBModFiles,
-    std::vector<ResourceContainer>& resourceContainerList, std::vector<SoundContainer>& soundContainerList,
-    std::vector<StreamDBContainer>& streamDBContainerList, std::vector<std::string>& notFoundContainers);
+// Mod files staged by a single task, merged once loading is done
+class StagedModFiles
+{
+public:
+    size_t Count{0};
+    std::map<ResourceContainer*, std::vector<ResourceModFile>> ResourceModFiles;
+    std::map<SoundContainer*, std::vector<SoundModFile>> SoundModFiles;
+    std::map<StreamDBContainer*, std::vector<StreamDBModFile>> StreamDBModFiles;
+    std::vector<std::string> NotFoundContainers;
+
+    void Merge(StagedModFiles& other);
+};
+
+// Load zipped mods into the container registries, splitting big archives across the thread pool if given
+void LoadZippedMod(std::string zippedMod, ThreadPool *threadPool,
+    ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers);
+
+// Load a mod package (.emlpack) into the container registries, without inflating or parsing any of its files
+void LoadPackagedMod(std::string packagedMod, ContainerRegistry<ResourceContainer>& resourceContainers,
+    ContainerRegistry<SoundContainer>& soundContainers, ContainerRegistry<StreamDBContainer>& streamDBContainers,
+    std::vector<std::string>& notFoundContainers);
+
+// List the containers a zipped mod loads files into for --list-res from its cached summary, without reading the files
+void ListZippedMod(std::string zippedMod, ListResourcesCache& listResourcesCache, ListedResources& listedResources,
+    ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers);
+
+// Load a loose mod file into a task's staged mod files
+void LoadUnzippedMod(std::string unzippedMod, const std::shared_ptr<const Mod>& globalLooseMod, StagedModFiles& stagedModFiles,
+    ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers);
+
+// Load loose mods in batches across the thread pool if given, and merge them in file order
+void LoadUnzippedMods(const std::vector<std::string>& unzippedMods, ThreadPool *threadPool, const std::shared_ptr<const Mod>& globalLooseMod,
+    StagedModFiles& looseModFiles, ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers);
+
+// Check the loose mod files for online safety and add them to their containers
+void AddLooseModFiles(StagedModFiles& looseModFiles, Mod& globalLooseMod);
+
+// Get the containers a zipped or packaged mod will load files into, from its central directory or routing table
+std::optional<std::set<std::string>> GetModContainerNames(const std::string& mod);
+
+// Get the containers the loose mod files will be loaded into
+std::set<std::string> GetUnzippedModContainerNames(const std::vector<std::string>& unzippedMods);
 
 #endif
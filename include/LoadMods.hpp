@@ -20,20 +20,29 @@
 #define LOADMODS_HPP
 
 #include <memory>
+#include <sstream>
+#include <string>
 #include "ResourceContainer.hpp"
 #include "ResourceData.hpp"
 #include "SoundContainer.hpp"
 #include "StreamDBContainer.hpp"
+#include "ThreadPool.hpp"
 
 // String stream output operations
-void InitStringStreams(size_t count);
-void OutputStringStream(int index);
+std::stringstream& NewStringStream();
+void OutputStringStreams();
+
+// Limit the mod data held by the injection threads at once
+void InitMemoryBudget(size_t limit);
+
+// Reuse the resource containers' tables of contents between runs
+void InitTocCache(const std::string& cachePath);
+bool SaveTocCache();
 
 // Load mods
 void LoadResourceMods(ResourceContainer& resourceContainer,
-    std::map<uint64_t, ResourceDataEntry>& resourceDataMap,
-    std::unique_ptr<std::byte[]>& buffer, int bufferSize);
-void LoadSoundMods(SoundContainer& soundContainer);
-void LoadStreamDBMods(StreamDBContainer& streamDBContainer, std::vector<StreamDBContainer>& streamDBContainerList);
+    std::map<uint64_t, ResourceDataEntry>& resourceDataMap, ThreadPool *threadPool, std::stringstream& os);
+void LoadSoundMods(SoundContainer& soundContainer, std::stringstream& os);
+void LoadStreamDBMods(StreamDBContainer& streamDBContainer, std::stringstream& os);
 
 #endif
@@ -0,0 +1,71 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+
+// Limits how many bytes of mod data tasks can hold at once
+// A task bigger than the whole budget waits until it can run alone
+class MemoryBudget
+{
+public:
+    MemoryBudget(size_t limit) : Limit(limit) {}
+
+    size_t Acquire(size_t bytes);
+    void Release(size_t bytes);
+private:
+    size_t Limit;
+    size_t Used{0};
+    std::mutex Mutex;
+    std::condition_variable BytesReleased;
+};
+
+// Bytes reserved from a budget until the reservation goes out of scope
+class MemoryReservation
+{
+public:
+    MemoryReservation(MemoryBudget *budget, size_t bytes) : Budget(budget), Bytes(budget != nullptr ? budget->Acquire(bytes) : 0) {}
+    ~MemoryReservation()
+    {
+        if (Budget != nullptr) {
+            Budget->Release(Bytes);
+        }
+    }
+
+    // Give back the reserved bytes, then wait for a new amount
+    // Never holds bytes while waiting, so tasks can't deadlock on each other
+    void Update(size_t bytes)
+    {
+        if (Budget != nullptr) {
+            Budget->Release(Bytes);
+            Bytes = Budget->Acquire(bytes);
+        }
+    }
+
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+private:
+    MemoryBudget *Budget;
+    size_t Bytes;
+};
+
+#endif
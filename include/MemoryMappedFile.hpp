@@ -32,18 +32,21 @@ public:
     std::string FilePath;
     std::byte *Mem;
     size_t Size{0};
+    bool ReadOnly{false};
 
-    MemoryMappedFile(const std::string filePath);
+    MemoryMappedFile(const std::string filePath, const bool readOnly = false);
     ~MemoryMappedFile();
 
     void UnmapFile();
     bool ResizeFile(const size_t newSize);
+    void DropPages(const size_t offset, const size_t length);
 private:
 #ifdef _WIN32
     HANDLE FileHandle;
     HANDLE FileMapping;
 #else
     int FileDescriptor;
+    size_t MappedSize{0};   // Mapped address range, grown ahead of the file so most resizes don't remap it
 #endif
 };
 
@@ -28,6 +28,7 @@ public:
     std::string Author;
     std::string Description;
     std::string Version;
+    std::string Path;
     bool IsSafeForOnline{true};
     int LoadPriority{0};
     int RequiredVersion{0};
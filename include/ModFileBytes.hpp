@@ -0,0 +1,91 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODFILEBYTES_HPP
+#define MODFILEBYTES_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "MemoryMappedFile.hpp"
+
+// Mod file data, either owned, viewed from a memory mapped mod archive,
+// or deferred until it's written: a deflated archive entry or a loose file on disk
+class ModFileBytes
+{
+public:
+    ModFileBytes() {}
+    ModFileBytes(std::vector<std::byte> bytes) : Bytes(std::move(bytes)), Length(Bytes.size()) {}
+    ModFileBytes(std::shared_ptr<MemoryMappedFile> archive, const size_t offset, const size_t length)
+        : Archive(archive), Offset(offset), Length(length) {}
+    ModFileBytes(std::shared_ptr<MemoryMappedFile> archive, const size_t offset, const size_t compressedLength, const size_t length, const uint32_t crc32)
+        : Archive(archive), Offset(offset), Length(length), CompressedLength(compressedLength), Crc32(crc32), Deflated(true) {}
+    ModFileBytes(std::string filePath, const size_t length) : FilePath(std::move(filePath)), Length(length) {}
+
+    ModFileBytes(const ModFileBytes&) = delete;
+    ModFileBytes& operator=(const ModFileBytes&) = delete;
+    ModFileBytes(ModFileBytes&&) = default;
+    ModFileBytes& operator=(ModFileBytes&&) = default;
+
+    // Deferred bytes have no data until they are loaded
+    const std::byte *data() const
+    {
+        if (IsDeferred()) {
+            return nullptr;
+        }
+
+        return (Archive != nullptr ? Archive->Mem : Bytes.data()) + Offset;
+    }
+
+    size_t size() const { return Length; }
+    bool empty() const { return Length == 0; }
+    const std::byte *begin() const { return data(); }
+    const std::byte *end() const { return data() + Length; }
+
+    bool IsDeferred() const { return Deflated || !FilePath.empty(); }
+
+    // Bytes written out of mod files, into containers or files, and how many of them were copied from memory
+    // rather than inflated or read straight into place, each write copying them at most once
+    static inline std::atomic<uint64_t> InjectedBytes{0};
+    static inline std::atomic<uint64_t> CopiedBytes{0};
+
+    void RemovePrefix(const size_t count);
+    bool Peek(std::byte *destination, const size_t count) const;
+    bool CopyTo(std::byte *destination) const;
+    bool CopyTo(std::byte *destination, const size_t offset, const size_t count) const;
+    bool WriteTo(FILE *file) const;
+    bool WriteTo(FILE *file, const size_t offset, const size_t count) const;
+    bool Verify() const;
+    bool Load();
+    void clear();
+private:
+    std::vector<std::byte> Bytes;
+    std::shared_ptr<MemoryMappedFile> Archive{nullptr};
+    std::string FilePath;
+    size_t Offset{0};
+    size_t Length{0};
+    size_t CompressedLength{0};
+    size_t Skip{0};
+    uint32_t Crc32{0};
+    bool Deflated{false};
+};
+
+#endif
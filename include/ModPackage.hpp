@@ -0,0 +1,75 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MODPACKAGE_HPP
+#define MODPACKAGE_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <cstdint>
+#include "AssetsInfo.hpp"
+#include "BlangFile.hpp"
+#include "MemoryMappedFile.hpp"
+
+#define PACKAGE_VERSION 1
+
+// Package entry flags
+enum PackageEntryFlags : uint32_t
+{
+    AssetsInfoEntry = 1 << 0,       // Payload is a pre-parsed assets info JSON
+    BlangJsonEntry = 1 << 1,        // Custom language file
+    ParsedBlangEntry = 1 << 2,      // Payload holds the language file's pre-parsed strings instead of its JSON
+    RedirectableEntry = 1 << 3,     // Follows --redirectBlangContainer
+    SkippedResourceEntry = 1 << 4   // Unused EternalMod file, ignored in resource containers
+};
+
+// Routing table entry: where a mod file goes and where its data is in the package
+class PackageEntry
+{
+public:
+    std::string ResourceName;
+    std::string Name;
+    uint64_t DataOffset{0};
+    uint64_t DataSize{0};
+    uint64_t TextureOffset{0};
+    uint64_t TextureSize{0};
+    uint32_t Flags{0};
+};
+
+// Loader-native mod package (.emlpack), converted from a zipped mod with --pack
+// Payloads are stored uncompressed and 4 KiB aligned, so they're injected straight from the mapped package,
+// and textures also get a DIVINITY compressed copy for --compress-textures
+class ModPackage
+{
+public:
+    std::shared_ptr<MemoryMappedFile> Package;
+    int LoadPriority{0};
+    int RequiredVersion{0};
+    std::vector<PackageEntry> Entries;
+
+    ModPackage(const std::string& packagePath);
+
+    class AssetsInfo ReadAssetsInfo(const PackageEntry& entry) const;
+    std::vector<BlangString> ReadBlangStrings(const PackageEntry& entry) const;
+
+    static bool Pack(const std::string& zippedMod, const std::string& packagePath, std::stringstream& os);
+};
+
+#endif
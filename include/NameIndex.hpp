@@ -0,0 +1,243 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAMEINDEX_HPP
+#define NAMEINDEX_HPP
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// Ids by name, in a single open addressing table
+// The names are viewed, so they must outlive the index
+// Only the first id added for a name is kept, matching the order of a linear search
+// A table loaded from storage is probed in place, until a name is added to it
+class NameIndex
+{
+public:
+    // A slot stored outside the index, with its name as a position in the names the index views
+    class StoredSlot
+    {
+    public:
+        uint32_t NameOffset{0};
+        uint32_t NameLength{0};
+        uint32_t Hash{0};
+        uint32_t Id{UINT32_MAX};
+    };
+
+    void clear()
+    {
+        Slots.clear();
+        Count = 0;
+        Stored = StoredTable();
+    }
+
+    void reserve(const size_t count)
+    {
+        Unstore();
+
+        // Keep the table at most 3/4 full
+        if (count * 4 > Slots.size() * 3) {
+            Rehash(count * 4 / 3 + 1);
+        }
+    }
+
+    void emplace(const std::string_view name, const size_t id)
+    {
+        reserve(Count + 1);
+
+        uint32_t hash = Hash(name);
+        Slot *slot = Probe(name, hash);
+
+        if (slot->Id == EmptySlot) {
+            *slot = Slot{name, hash, static_cast<uint32_t>(id)};
+            Count++;
+        }
+    }
+
+    // Get the id for a name, or -1 if it isn't indexed
+    ssize_t find(const std::string_view name) const
+    {
+        if (Stored.Slots != nullptr) {
+            return FindStored(name, Hash(name));
+        }
+
+        if (Slots.empty()) {
+            return -1;
+        }
+
+        const Slot *slot = Probe(name, Hash(name));
+        return slot->Id == EmptySlot ? -1 : static_cast<ssize_t>(slot->Id);
+    }
+
+    static uint32_t Hash(const std::string_view name)
+    {
+        return static_cast<uint32_t>(std::hash<std::string_view>()(name));
+    }
+
+    // Store the table as is, every name must be in the given names
+    std::vector<StoredSlot> Store(const char *names) const
+    {
+        if (Stored.Slots != nullptr) {
+            return std::vector<StoredSlot>(Stored.Slots, Stored.Slots + Stored.SlotCount);
+        }
+
+        std::vector<StoredSlot> storedSlots(Slots.size());
+
+        for (size_t i = 0; i < Slots.size(); i++) {
+            if (Slots[i].Id != EmptySlot) {
+                storedSlots[i] = StoredSlot{static_cast<uint32_t>(Slots[i].Name.data() - names),
+                    static_cast<uint32_t>(Slots[i].Name.size()), Slots[i].Hash, Slots[i].Id};
+            }
+        }
+
+        return storedSlots;
+    }
+
+    // Use a stored table in place, with its names at the same positions in the given names
+    // Slots aren't read until they're probed, the ones with ids from idCount on are treated as missing
+    // The storage is kept alive by the index
+    bool Load(std::shared_ptr<const void> storage, const StoredSlot *storedSlots, const size_t slotCount,
+        const size_t idCount, const char *names, const size_t namesSize)
+    {
+        clear();
+
+        if (slotCount != 0 && (slotCount < 64 || (slotCount & (slotCount - 1)) != 0)) {
+            return false;
+        }
+
+        Stored = StoredTable{std::move(storage), storedSlots, slotCount, idCount, names, namesSize};
+        return true;
+    }
+private:
+    static constexpr uint32_t EmptySlot = UINT32_MAX;
+
+    class StoredTable
+    {
+    public:
+        std::shared_ptr<const void> Storage;
+        const StoredSlot *Slots{nullptr};
+        size_t SlotCount{0};
+        size_t IdCount{0};
+        const char *Names{nullptr};
+        size_t NamesSize{0};
+
+        // Stored names out of bounds never match
+        std::string_view GetName(const StoredSlot& slot) const
+        {
+            if (slot.NameOffset > NamesSize || slot.NameLength > NamesSize - slot.NameOffset) {
+                return std::string_view();
+            }
+
+            return std::string_view(Names + slot.NameOffset, slot.NameLength);
+        }
+    };
+
+    class Slot
+    {
+    public:
+        std::string_view Name;
+        uint32_t Hash{0};
+        uint32_t Id{EmptySlot};
+    };
+
+    std::vector<Slot> Slots;
+    size_t Count{0};
+    StoredTable Stored;
+
+    ssize_t FindStored(const std::string_view name, const uint32_t hash) const
+    {
+        if (Stored.SlotCount == 0) {
+            return -1;
+        }
+
+        size_t mask = Stored.SlotCount - 1;
+
+        // A stored table isn't trusted to have an empty slot
+        for (size_t i = hash & mask, probes = 0; probes < Stored.SlotCount; i = (i + 1) & mask, probes++) {
+            const StoredSlot& slot = Stored.Slots[i];
+
+            if (slot.Id == EmptySlot) {
+                return -1;
+            }
+
+            if (slot.Hash == hash && Stored.GetName(slot) == name) {
+                return slot.Id < Stored.IdCount ? static_cast<ssize_t>(slot.Id) : -1;
+            }
+        }
+
+        return -1;
+    }
+
+    // Copy a stored table into the index before it's changed
+    void Unstore()
+    {
+        if (Stored.Slots == nullptr) {
+            return;
+        }
+
+        StoredTable stored = std::move(Stored);
+        Stored = StoredTable();
+        Slots.resize(stored.SlotCount);
+
+        for (size_t i = 0; i < stored.SlotCount; i++) {
+            if (stored.Slots[i].Id != EmptySlot && stored.Slots[i].Id < stored.IdCount) {
+                Slots[i] = Slot{stored.GetName(stored.Slots[i]), stored.Slots[i].Hash, stored.Slots[i].Id};
+                Count++;
+            }
+        }
+    }
+
+    // Find the slot holding a name, or the empty slot where it would go
+    Slot *Probe(const std::string_view name, const uint32_t hash) const
+    {
+        size_t mask = Slots.size() - 1;
+
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = Slots[i];
+
+            if (slot.Id == EmptySlot || (slot.Hash == hash && slot.Name == name)) {
+                return const_cast<Slot*>(&slot);
+            }
+        }
+    }
+
+    void Rehash(const size_t minimumCapacity)
+    {
+        size_t capacity = 64;
+
+        while (capacity < minimumCapacity) {
+            capacity *= 2;
+        }
+
+        std::vector<Slot> oldSlots(capacity);
+        Slots.swap(oldSlots);
+
+        for (const auto& slot : oldSlots) {
+            if (slot.Id != EmptySlot) {
+                *Probe(slot.Name, slot.Hash) = slot;
+            }
+        }
+    }
+};
+
+#endif
@@ -27,6 +27,11 @@
 std::vector<ResourceModFile> GetMultiplayerDisablerMods();
 
 // Check if mod is safe for online
-bool IsModSafeForOnline(const std::map<size_t, std::vector<ResourceModFile>>& resourceModFiles);
+bool IsModSafeForOnline(const std::map<ResourceContainer*, std::vector<ResourceModFile>>& resourceModFiles);
+
+// Check a single mod file or container against the online safety rules
+bool IsUnsafeResourceName(const std::string& resourceName);
+bool IsModFileSafeForUnsafeResource(const std::string& modFileName);
+bool IsMultiplayerDisablerFile(const std::string& modFileName);
 
 #endif
@@ -34,6 +34,7 @@ class Oodle
 public:
     static std::vector<std::byte> Decompress(std::vector<std::byte>& compressedData, const size_t decompressedSize);
     static std::vector<std::byte> Compress(std::vector<std::byte>& compressedData);
+    static std::vector<std::byte> Compress(const std::byte *decompressedData, const size_t decompressedSize);
 };
 
 #endif
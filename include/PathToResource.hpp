@@ -20,12 +20,16 @@
 #define PATHTORESOURCE_HPP
 
 #include <string>
+#include <vector>
 
-// Populate container path list
+// Populate container path list and the lookup indexes
 void GetResourceContainerPathList();
 
-// Get container paths
+// Get container paths from the indexes, without touching the filesystem
 std::string PathToResourceContainer(const std::string& name);
 std::string PathToSoundContainer(const std::string& name);
 
+// Get the paths of every .resources container in base/ and game/
+std::vector<std::string> GetAllResourceContainerPaths();
+
 #endif
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 
 #define VERSION 23
 
@@ -45,6 +46,11 @@ public:
     inline static bool LoadOnlineSafeModsOnly{false};
     inline static bool CompressTextures{false};
     inline static bool MultiThreading{true};
+    inline static size_t Jobs{0};
+    inline static size_t MaxMemory{0};
+    inline static bool PackMods{false};
+    inline static bool RepackContainers{false};
+    inline static std::vector<std::string> RepackContainerNames;
     inline static bool AreModsSafeForOnline{true};
     inline static std::string BlangFileContainerRedirect;
 
@@ -19,10 +19,41 @@
 #ifndef READCHUNKINFO_HPP
 #define READCHUNKINFO_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include "MemoryMappedFile.hpp"
 #include "ResourceContainer.hpp"
+#include "ThreadPool.hpp"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "Resource container records are read as little endian values"
+#endif
+
+// File info record, 0x90 bytes per chunk
+struct ResourceFileInfo
+{
+    std::byte Unknown1[0x20];
+    uint64_t NameIdIndex;
+    std::byte Unknown2[0x10];
+    uint64_t DataOffset;
+    uint64_t SizeZ;
+    uint64_t Size;
+    std::byte Unknown3[0x20];
+    std::byte CompressionMode;
+    std::byte Unknown4[0x1F];
+};
+
+static_assert(sizeof(ResourceFileInfo) == 0x90, "File info records are 0x90 bytes");
+static_assert(offsetof(ResourceFileInfo, NameIdIndex) == 0x20 && offsetof(ResourceFileInfo, DataOffset) == 0x38
+    && offsetof(ResourceFileInfo, CompressionMode) == 0x70, "Unexpected file info record layout");
+
+// Position of a chunk's data offset in the container, followed by its sizes
+inline uint64_t GetChunkFileOffset(const uint64_t infoOffset, const size_t chunk)
+{
+    return infoOffset + sizeof(ResourceFileInfo) * chunk + offsetof(ResourceFileInfo, DataOffset);
+}
 
 // Replace chunks with mods in resource file
-void ReadChunkInfo(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer);
+void ReadChunkInfo(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer, ThreadPool *threadPool);
 
 #endif
@@ -21,8 +21,9 @@
 
 #include "MemoryMappedFile.hpp"
 #include "ResourceContainer.hpp"
+#include "ThreadPool.hpp"
 
 // Read resource file
-void ReadResource(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer);
+void ReadResource(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer, ThreadPool *threadPool);
 
 #endif
@@ -0,0 +1,37 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef REPACKCONTAINERS_HPP
+#define REPACKCONTAINERS_HPP
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <cstdint>
+#include "MemoryBudget.hpp"
+#include "ThreadPool.hpp"
+
+// Rebuild a .resources container with only the data its chunks use, in chunk table order
+// Returns how many bytes the container shrank by, or -1 if it couldn't be repacked
+int64_t RepackContainer(const std::string& containerPath, MemoryBudget *ioBudget, ThreadPool *threadPool, std::stringstream& os);
+
+// Repack the containers, in parallel if there's a thread pool, and report the bytes reclaimed
+void RepackContainers(const std::vector<std::string>& containerPaths, ThreadPool *threadPool);
+
+#endif
@@ -19,14 +19,13 @@
 #ifndef REPLACECHUNKS_HPP
 #define REPLACECHUNKS_HPP
 
-#include <memory>
 #include "MemoryMappedFile.hpp"
 #include "ResourceContainer.hpp"
 #include "ResourceData.hpp"
+#include "ThreadPool.hpp"
 
 // Replace chunks with mods in resource file
 void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer,
-    std::map<uint64_t, ResourceDataEntry>& resourceDataMap, std::stringstream& os,
-    std::unique_ptr<std::byte[]>& buffer, int bufferSize);
+    std::map<uint64_t, ResourceDataEntry>& resourceDataMap, ThreadPool *threadPool, std::stringstream& os);
 
 #endif
@@ -20,20 +20,29 @@
 #define RESOURCECONTAINER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
+#include <memory>
 #include <optional>
 #include "AssetsInfo.hpp"
+#include "BlangFile.hpp"
+#include "ChunkTable.hpp"
 #include "Mod.hpp"
+#include "ModFileBytes.hpp"
+#include "NameIndex.hpp"
 #include "ProgramOptions.hpp"
+#include "Utils.hpp"
 
 class ResourceModFile
 {
 public:
-    Mod Parent;
+    std::shared_ptr<const Mod> Parent;
     std::string Name;
     std::string ResourceName;
-    std::vector<std::byte> FileBytes;
+    ModFileBytes FileBytes;
     bool IsBlangJson{false};
+    std::optional<std::vector<BlangString>> BlangStrings{std::nullopt};
     bool IsAssetsInfoJson{false};
     std::optional<class AssetsInfo> AssetsInfo{std::nullopt};
     std::optional<uint64_t> StreamDbHash{std::nullopt};
@@ -47,37 +56,27 @@ public:
     std::optional<std::byte> SpecialByte3{std::nullopt};
     bool Announce{true};
 
-    ResourceModFile(Mod parent, std::string name, std::string resourceName, bool announce = true)
-        : Parent(parent), Name(name), ResourceName(resourceName), Announce(announce) {}
+    ResourceModFile(std::shared_ptr<const Mod> parent, std::string name, std::string resourceName, bool announce = true)
+        : Parent(std::move(parent)), Name(name), ResourceName(resourceName), Announce(announce) {}
+
+    // Mod files are only ever moved, so their data is never copied by accident
+    ResourceModFile(const ResourceModFile&) = delete;
+    ResourceModFile& operator=(const ResourceModFile&) = delete;
+    ResourceModFile(ResourceModFile&&) = default;
+    ResourceModFile& operator=(ResourceModFile&&) = default;
 };
 
+// A name in a container's names section, viewed from the container's name storage
 class ResourceName
 {
 public:
-    std::string FullFileName;
-    std::string NormalizedFileName;
+    std::string_view FullFileName;
 
     ResourceName() {}
-    ResourceName(std::string fullFileName, std::string normalizedFileName) : FullFileName(fullFileName), NormalizedFileName(normalizedFileName) {}
-};
-
-class ResourceChunk
-{
-public:
-    class ResourceName ResourceName;
-    uint64_t FileOffset{0};
-    uint64_t SizeOffset{0};
-    uint64_t SizeZ{0};
-    uint64_t Size{0};
-    std::byte CompressionMode{0};
-
-    ResourceChunk() {}
-    ResourceChunk(class ResourceName name, uint64_t fileOffset) : ResourceName(name), FileOffset(fileOffset) {}
+    ResourceName(std::string_view fullFileName) : FullFileName(fullFileName) {}
 
-    bool operator==(const ResourceChunk& chunk)
-    {
-        return ResourceName.FullFileName == chunk.ResourceName.FullFileName && FileOffset == chunk.FileOffset;
-    }
+    // Support "normalized" filenames too (backwards compatibility), they're always part of the full name
+    std::string_view NormalizedFileName() const { return NormalizeResourceFilename(FullFileName); }
 };
 
 class ResourceContainer
@@ -98,33 +97,64 @@ public:
     uint64_t NamesOffsetEnd{0};
     uint64_t UnknownOffset{0};
     uint64_t UnknownOffset2{0};
+    std::shared_ptr<const char[]> NamesData;
+    std::deque<std::string> AddedNames;
     std::vector<ResourceName> NamesList;
-    std::vector<ResourceChunk> ChunkList;
+    ChunkTable Chunks;
+    NameIndex ChunkIndex;
     std::vector<ResourceModFile> ModFileList;
     std::vector<ResourceModFile> NewModFileList;
 
     ResourceContainer(std::string name, std::string path): Name(name), Path(path) {}
 
-    bool ContainsResourceWithName(std::string name) const
+    // The names list and indexes view the container's name storage, so containers are only ever moved
+    ResourceContainer(const ResourceContainer&) = delete;
+    ResourceContainer& operator=(const ResourceContainer&) = delete;
+    ResourceContainer(ResourceContainer&&) = default;
+    ResourceContainer& operator=(ResourceContainer&&) = default;
+
+    const ResourceName& GetChunkName(const size_t chunk) const
     {
-        for (auto& resourceName : NamesList) {
-            if (resourceName.FullFileName == name || resourceName.NormalizedFileName == name) {
-                return true;
-            }
-        }
+        return NamesList[Chunks.NameIds[chunk]];
+    }
 
-        return false;
+    // Add a name at the end of the names list, stored with the container
+    void AddResourceName(const std::string& name)
+    {
+        NamesList.emplace_back(AddedNames.emplace_back(name));
     }
 
-    ssize_t GetResourceNameId(std::string name) const
+    bool ContainsResourceWithName(const std::string_view name) const
     {
-        for (size_t i = 0; i < NamesList.size(); i++) {
-            if (NamesList[i].FullFileName == name || NamesList[i].NormalizedFileName == name) {
-                return i;
-            }
+        return GetResourceNameId(name) != -1;
+    }
+
+    ssize_t GetResourceNameId(const std::string_view name) const
+    {
+        IndexResourceNames();
+        return NameIds.find(name);
+    }
+private:
+    // Name ids by full and normalized name, catching up with the names appended to the list since the last lookup
+    mutable NameIndex NameIds;
+    mutable size_t IndexedNameCount{0};
+
+    void IndexResourceNames() const
+    {
+        if (IndexedNameCount == 0) {
+            NameIds.reserve(NamesList.size());
         }
 
-        return -1;
+        // Only the first id is kept for a name, like a linear search
+        for (; IndexedNameCount < NamesList.size(); IndexedNameCount++) {
+            const ResourceName& name = NamesList[IndexedNameCount];
+            std::string_view normalizedName = name.NormalizedFileName();
+            NameIds.emplace(name.FullFileName, IndexedNameCount);
+
+            if (normalizedName.size() != name.FullFileName.size()) {
+                NameIds.emplace(normalizedName, IndexedNameCount);
+            }
+        }
     }
 };
 
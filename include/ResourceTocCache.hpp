@@ -0,0 +1,54 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef RESOURCETOCCACHE_HPP
+#define RESOURCETOCCACHE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include "MemoryMappedFile.hpp"
+#include "ResourceContainer.hpp"
+
+#define RESOURCE_TOC_CACHE_VERSION 3
+
+// Parsed tables of contents of resource containers, kept between runs
+// An entry is used while its container's size, write time and header are unchanged,
+// so containers restored from a backup are loaded without reading their names and chunk info again
+// Loaded containers view their names and chunk index in the mapped cache, keeping it mapped
+class ResourceTocCache
+{
+public:
+    ResourceTocCache(const std::string& cachePath);
+
+    bool Load(const MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer);
+    void Store(const MemoryMappedFile& memoryMappedFile, const ResourceContainer& resourceContainer);
+    bool Save();
+private:
+    std::string CachePath;
+    std::shared_ptr<MemoryMappedFile> CacheFile;
+    std::map<std::string, size_t> Entries;  // Offset of each container's entry in the cache file
+    std::mutex Mutex;
+    std::map<std::string, std::vector<std::byte>> NewEntries;
+};
+
+#endif
@@ -16,23 +16,21 @@
 * along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
 */
 
+
 #ifndef SETMODDATAFORCHUNK_HPP
 #define SETMODDATAFORCHUNK_HPP
 
-#include <memory>
-#include "MemoryMappedFile.hpp"
+#include "ChunkWritePlan.hpp"
 #include "ResourceContainer.hpp"
 
-// Write mod into chunk
+// Write mod into chunk, once the plan is written
 bool SetModDataForChunk(
-    MemoryMappedFile& memoryMappedFile,
     ResourceContainer& resourceContainer,
-    ResourceChunk& chunk,
+    const size_t chunk,
     ResourceModFile& modFile,
     const uint64_t compressedSize,
     const uint64_t uncompressedSize,
     const std::byte *compressionMode,
-    std::unique_ptr<std::byte[]>& buffer,
-    int bufferSize);
+    ChunkWritePlan& writePlan);
 
 #endif
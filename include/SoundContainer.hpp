@@ -21,16 +21,23 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include "Mod.hpp"
+#include "ModFileBytes.hpp"
 
 class SoundModFile
 {
 public:
-    Mod Parent;
+    std::shared_ptr<const Mod> Parent;
     std::string Name;
-    std::vector<std::byte> FileBytes;
+    ModFileBytes FileBytes;
 
-    SoundModFile(Mod parent, std::string name) : Parent(parent), Name(name) {}
+    SoundModFile(std::shared_ptr<const Mod> parent, std::string name) : Parent(std::move(parent)), Name(name) {}
+
+    SoundModFile(const SoundModFile&) = delete;
+    SoundModFile& operator=(const SoundModFile&) = delete;
+    SoundModFile(SoundModFile&&) = default;
+    SoundModFile& operator=(SoundModFile&&) = default;
 };
 
 class SoundEntry
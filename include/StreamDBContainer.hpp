@@ -21,7 +21,9 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include "Mod.hpp"
+#include "ModFileBytes.hpp"
 
 class StreamDBHeader
 {
@@ -45,25 +47,35 @@ public:
     unsigned int DataOffset16{0};
     unsigned int DataLength{0};
     std::string Name;
-    std::vector<std::byte> FileData;
+    const ModFileBytes *FileData;   // The streamdb mod file holding the data
+    size_t FileDataOffset;
 
-    StreamDBEntry(uint64_t fileId, unsigned int dataOffset16, unsigned int dataLength, std::string name, std::vector<std::byte> fileData)
-        : FileId(fileId), DataOffset16(dataOffset16), DataLength(dataLength), Name(name), FileData(fileData) {}
+    StreamDBEntry(uint64_t fileId, unsigned int dataOffset16, unsigned int dataLength, std::string name, const ModFileBytes *fileData, size_t fileDataOffset)
+        : FileId(fileId), DataOffset16(dataOffset16), DataLength(dataLength), Name(name), FileData(fileData), FileDataOffset(fileDataOffset) {}
+
+    StreamDBEntry(const StreamDBEntry&) = delete;
+    StreamDBEntry& operator=(const StreamDBEntry&) = delete;
+    StreamDBEntry(StreamDBEntry&&) = default;
+    StreamDBEntry& operator=(StreamDBEntry&&) = default;
 };
 
 class StreamDBModFile
 {
 public:
-    Mod Parent;
+    std::shared_ptr<const Mod> Parent;
     std::string Name;
     uint64_t FileId{0};
-    std::vector<std::byte> FileData;
+    ModFileBytes FileData;
     int LODcount{0};
     std::vector<int> LODDataOffset;
     std::vector<int> LODDataLength;
-    std::vector<std::vector<std::byte>> LODFileData;
 
-    StreamDBModFile(Mod parent, std::string name) : Parent(parent), Name(name) {}
+    StreamDBModFile(std::shared_ptr<const Mod> parent, std::string name) : Parent(std::move(parent)), Name(name) {}
+
+    StreamDBModFile(const StreamDBModFile&) = delete;
+    StreamDBModFile& operator=(const StreamDBModFile&) = delete;
+    StreamDBModFile(StreamDBModFile&&) = default;
+    StreamDBModFile& operator=(StreamDBModFile&&) = default;
 };
 
 class StreamDBContainer
@@ -74,6 +86,7 @@ public:
     StreamDBHeader Header;
     std::vector<StreamDBModFile> ModFiles;
     std::vector<StreamDBEntry> StreamDBEntries;
+    bool BuildFailed{false};    // The file couldn't be built and was removed
 
     StreamDBContainer(std::string name, std::string path) : Name(name), Path(path) {}
 };
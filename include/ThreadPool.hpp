@@ -0,0 +1,91 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+// Group of tasks that can be waited on separately,
+// so running tasks can submit more tasks and wait for them
+class TaskGroup
+{
+public:
+    std::atomic<size_t> PendingTasks{0};
+    std::atomic<size_t> QueuedTasks{0};
+    std::exception_ptr FirstException{nullptr};
+};
+
+// Fixed-size pool of worker threads, each with its own task queue
+// Idle workers steal tasks from the other queues
+class ThreadPool
+{
+public:
+    ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    void Submit(std::function<void()> task, TaskGroup *group = nullptr);
+    void Wait();
+    void Wait(TaskGroup& group);
+    size_t ThreadCount() const { return Threads.size(); }
+
+    static size_t GetDefaultThreadCount();
+private:
+    class Task
+    {
+    public:
+        std::function<void()> Function;
+        TaskGroup *Group{nullptr};
+    };
+
+    class WorkerQueue
+    {
+    public:
+        std::mutex Mutex;
+        std::deque<Task> Tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> Queues;
+    std::vector<std::thread> Threads;
+    std::atomic<size_t> PendingTasks{0};
+    std::atomic<size_t> QueuedTasks{0};
+    std::atomic<size_t> NextQueue{0};
+    std::mutex StateMutex;
+    std::condition_variable TaskAvailable;
+    std::condition_variable TasksFinished;
+    bool Stopping{false};
+    std::exception_ptr FirstException{nullptr};
+
+    bool PopTask(size_t queueIndex, Task& task);
+    bool StealTask(size_t queueIndex, Task& task);
+    bool TakeTask(Task& task);
+    bool TakeGroupTask(TaskGroup& group, Task& task);
+    void RunTask(Task& task);
+    void WorkerLoop(size_t queueIndex);
+};
+
+#endif
@@ -20,14 +20,14 @@
 #define UTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 std::string RemoveWhitespace(const std::string& stringWithWhitespace);
 std::string ToLower(const std::string& str);
 std::vector<std::string> SplitString(std::string stringToSplit, const char delimiter);
-bool EndsWith(const std::string& fullString, const std::string& suffix);
-bool StartsWith(const std::string& fullString, const std::string& prefix);
-std::string NormalizeResourceFilename(std::string filename);
-int GetClusterSize();
+bool EndsWith(const std::string_view fullString, const std::string_view suffix);
+bool StartsWith(const std::string_view fullString, const std::string_view prefix);
+std::string_view NormalizeResourceFilename(std::string_view filename);
 
 #endif
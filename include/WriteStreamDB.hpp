@@ -23,7 +23,6 @@
 
 // Build and write custom StreamDB
 void BuildStreamDBIndex(StreamDBContainer& streamDBContainer, std::stringstream& os);
-void WriteStreamDBFile(FILE *streamDBFile, const StreamDBContainer& streamDBContainer,
-    std::vector<StreamDBContainer>& streamDBContainerList, std::stringstream& os);
+bool WriteStreamDBFile(FILE *streamDBFile, const StreamDBContainer& streamDBContainer, std::stringstream& os);
 
 #endif
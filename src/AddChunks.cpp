@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cstring>
 #include <sstream>
+#include <unordered_map>
 #include "Colors.hpp"
 #include "Oodle.hpp"
 #include "ProgramOptions.hpp"
@@ -34,7 +35,7 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
 
     // Sort mod file list by priority
     std::stable_sort(resourceContainer.NewModFileList.begin(), resourceContainer.NewModFileList.end(),
-        [](const ResourceModFile& resource1, const ResourceModFile& resource2) { return resource1.Parent.LoadPriority > resource2.Parent.LoadPriority; });
+        [](const ResourceModFile& resource1, const ResourceModFile& resource2) { return resource1.Parent->LoadPriority > resource2.Parent->LoadPriority; });
 
     // Get individual sections
     std::vector<std::byte> header(memoryMappedFile.Mem, memoryMappedFile.Mem + resourceContainer.InfoOffset);
@@ -55,8 +56,19 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
 
     std::vector<std::byte> idcl(memoryMappedFile.Mem + resourceContainer.IdclOffset, memoryMappedFile.Mem + resourceContainer.DataOffset);
 
-    std::vector<std::byte> data(memoryMappedFile.Mem + resourceContainer.DataOffset, memoryMappedFile.Mem + memoryMappedFile.Size);
-    size_t originalDataSize = data.size();
+    // The data section isn't copied, the new data is appended to it in the container,
+    // and the whole section is moved once at the end to make room for the bigger tables
+    size_t dataSize = memoryMappedFile.Size - resourceContainer.DataOffset;
+    size_t newDataSize = 0;
+
+    for (const auto& modFile : resourceContainer.NewModFileList) {
+        newDataSize += modFile.FileBytes.size() + 0x40;
+    }
+
+    if (!memoryMappedFile.ResizeFile(memoryMappedFile.Size + newDataSize)) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to resize " << resourceContainer.Path << '\n';
+        return;
+    }
 
     size_t infoOldLength = info.size();
     size_t nameIdsOldLength = nameIds.size();
@@ -66,33 +78,42 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
     // Find the resource data for the new mod files and set them
     for (auto& modFile : resourceContainer.ModFileList) {
         if (modFile.IsAssetsInfoJson && modFile.AssetsInfo.has_value() && !modFile.AssetsInfo.value().Assets.empty()) {
+            // Index the assets by the names of the files they describe, keeping the first asset for each name
+            std::unordered_map<std::string, const AssetsInfoAsset*> assetsByName;
+
+            for (auto& assetsInfoAssets : modFile.AssetsInfo.value().Assets) {
+                std::string normalPath = assetsInfoAssets.Name;
+                std::string declPath = normalPath;
+
+                if (!assetsInfoAssets.MapResourceType.empty()) {
+                    declPath = "generated/decls/" + ToLower(assetsInfoAssets.MapResourceType) + "/" + assetsInfoAssets.Name + ".decl";
+                }
+
+                assetsByName.emplace(declPath, &assetsInfoAssets);
+                assetsByName.emplace(normalPath, &assetsInfoAssets);
+            }
+
             for (auto& newModFile : resourceContainer.NewModFileList) {
-                for (auto& assetsInfoAssets : modFile.AssetsInfo.value().Assets) {
-                    std::string normalPath = assetsInfoAssets.Name;
-                    std::string declPath = normalPath;
+                auto x = assetsByName.find(newModFile.Name);
 
-                    if (!assetsInfoAssets.MapResourceType.empty()) {
-                        declPath = "generated/decls/" + ToLower(assetsInfoAssets.MapResourceType) + "/" + assetsInfoAssets.Name + ".decl";
-                    }
+                if (x == assetsByName.end()) {
+                    continue;
+                }
 
-                    if (newModFile.Name == declPath || newModFile.Name == normalPath) {
-                        newModFile.ResourceType = assetsInfoAssets.ResourceType.empty() ? "rs_streamfile" : assetsInfoAssets.ResourceType;
-                        newModFile.Version = static_cast<unsigned short>(assetsInfoAssets.Version);
-                        newModFile.StreamDbHash = assetsInfoAssets.StreamDbHash;
-                        newModFile.SpecialByte1 = assetsInfoAssets.SpecialByte1;
-                        newModFile.SpecialByte2 = assetsInfoAssets.SpecialByte2;
-                        newModFile.SpecialByte3 = assetsInfoAssets.SpecialByte3;
-                        newModFile.PlaceBefore = assetsInfoAssets.PlaceBefore;
-                        newModFile.PlaceByName = assetsInfoAssets.PlaceByName;
-                        newModFile.PlaceByType = assetsInfoAssets.PlaceByType;
-
-                        if (ProgramOptions::Verbose) {
-                            os << "\tSet resources type " << newModFile.ResourceType << " (version: " << newModFile.Version.value()
-                                << ", streamdb hash: " << newModFile.StreamDbHash.value() << ") for new file: " << newModFile.Name << '\n';
-                        }
+                const AssetsInfoAsset& assetsInfoAssets = *x->second;
+                newModFile.ResourceType = assetsInfoAssets.ResourceType.empty() ? "rs_streamfile" : assetsInfoAssets.ResourceType;
+                newModFile.Version = static_cast<unsigned short>(assetsInfoAssets.Version);
+                newModFile.StreamDbHash = assetsInfoAssets.StreamDbHash;
+                newModFile.SpecialByte1 = assetsInfoAssets.SpecialByte1;
+                newModFile.SpecialByte2 = assetsInfoAssets.SpecialByte2;
+                newModFile.SpecialByte3 = assetsInfoAssets.SpecialByte3;
+                newModFile.PlaceBefore = assetsInfoAssets.PlaceBefore;
+                newModFile.PlaceByName = assetsInfoAssets.PlaceByName;
+                newModFile.PlaceByType = assetsInfoAssets.PlaceByType;
 
-                        break;
-                    }
+                if (ProgramOptions::Verbose) {
+                    os << "\tSet resources type " << newModFile.ResourceType << " (version: " << newModFile.Version.value()
+                        << ", streamdb hash: " << newModFile.StreamDbHash.value() << ") for new file: " << newModFile.Name << '\n';
                 }
             }
         }
@@ -111,7 +132,7 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
                     << " that has already been added to " << resourceContainer.Name << ", skipping" << '\n';
             }
 
-            modFile.FileBytes.resize(0);
+            modFile.FileBytes.clear();
             continue;
         }
 
@@ -144,18 +165,79 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
             }
         }
 
-        // Check if the resource type name exists in the current container, and add it if it doesn't
-        if (!modFile.ResourceType.empty()) {
-            bool found = false;
+        // Write the data first, so a file that fails doesn't leave its names behind
+        // If this is a texture, check if it's compressed, or compress if necessary
+        uint64_t compressedSize = modFile.FileBytes.size();
+        uint64_t uncompressedSize = compressedSize;
+        std::byte compressionMode{0};
+
+        if ((modFile.Name.find(".tga") != std::string::npos || modFile.Name.find(".png") != std::string::npos) && compressedSize != 0) {
+            // Check if it's a DIVINITY compressed texture
+            std::byte divinityHeader[16];
+
+            if (modFile.FileBytes.Peek(divinityHeader, sizeof(divinityHeader)) && std::memcmp(divinityHeader, "DIVINITY", 8) == 0) {
+                // This is a compressed texture, read the uncompressed size
+                std::copy(divinityHeader + 8, divinityHeader + 16, reinterpret_cast<std::byte*>(&uncompressedSize));
+
+                // Set the compressed texture data, skipping the DIVINITY header (16 bytes)
+                modFile.FileBytes.RemovePrefix(16);
+                compressedSize = modFile.FileBytes.size();
+                compressionMode = std::byte{2};
 
-            for (auto& name : resourceContainer.NamesList) {
-                if (name.NormalizedFileName == modFile.ResourceType) {
-                    found = true;
-                    break;
+                if (ProgramOptions::Verbose) {
+                    os << "\tSuccessfully set compressed texture data for file " << modFile.Name << '\n';
                 }
             }
+            else if (ProgramOptions::CompressTextures) {
+                // Compress the texture
+                std::vector<std::byte> compressedData;
+
+                try {
+                    if (!modFile.FileBytes.Load()) {
+                        throw std::exception();
+                    }
+
+                    compressedData = Oodle::Compress(modFile.FileBytes.data(), modFile.FileBytes.size());
+
+                    if (compressedData.empty()) {
+                        throw std::exception();
+                    }
+                }
+                catch (...) {
+                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to compress " << modFile.Name << '\n';
+                    continue;
+                }
+
+                modFile.FileBytes = std::move(compressedData);
+                compressedSize = modFile.FileBytes.size();
+                compressionMode = std::byte{2};
+
+                if (ProgramOptions::Verbose) {
+                    os << "\tSuccessfully compressed texture file " << modFile.Name << '\n';
+                }
+            }
+        }
+
+        // Add the mod file data at the end of the data section
+        size_t placement = 0x10 - (dataSize % 0x10) + 0x30;
+        uint64_t fileOffset = resourceContainer.DataOffset + dataSize + placement;
+
+        // Compressed textures can end up bigger than the space reserved for them
+        if (fileOffset + modFile.FileBytes.size() > memoryMappedFile.Size && !memoryMappedFile.ResizeFile(fileOffset + modFile.FileBytes.size())) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to resize " << resourceContainer.Path << '\n';
+            continue;
+        }
+
+        if (!modFile.FileBytes.CopyTo(memoryMappedFile.Mem + fileOffset)) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to extract " << modFile.Name << '\n';
+            continue;
+        }
 
-            if (!found) {
+        dataSize += placement + modFile.FileBytes.size();
+
+        // Check if the resource type name exists in the current container, and add it if it doesn't
+        if (!modFile.ResourceType.empty()) {
+            if (!resourceContainer.ContainsResourceWithName(modFile.ResourceType)) {
                 // Add type name
                 uint64_t typeLastOffset;
                 std::copy(nameOffsets.end() - 8, nameOffsets.end(), reinterpret_cast<std::byte*>(&typeLastOffset));
@@ -183,8 +265,7 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
                 std::copy(reinterpret_cast<std::byte*>(&typeLastNameOffset), reinterpret_cast<std::byte*>(&typeLastNameOffset) + 8, nameOffsets.end() - 8);
 
                 // Add the type name to the list to keep the indexes in the proper order
-                ResourceName newResourceName(modFile.ResourceType, modFile.ResourceType);
-                resourceContainer.NamesList.push_back(newResourceName);
+                resourceContainer.AddResourceName(modFile.ResourceType);
 
                 os << "\tAdded resource type name " << modFile.ResourceType << " to " << resourceContainer.Name << '\n';
             }
@@ -218,61 +299,7 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
         std::copy(reinterpret_cast<std::byte*>(&lastNameOffset), reinterpret_cast<std::byte*>(&lastNameOffset) + 8, nameOffsets.end() - 8);
 
         // Add the name to the list to keep the indexes in the proper order
-        ResourceName newResourceName(modFile.Name, modFile.Name);
-        resourceContainer.NamesList.push_back(newResourceName);
-
-        // If this is a texture, check if it's compressed, or compress if necessary
-        uint64_t compressedSize = modFile.FileBytes.size();
-        uint64_t uncompressedSize = compressedSize;
-        std::byte compressionMode{0};
-
-        if ((modFile.Name.find(".tga") != std::string::npos || modFile.Name.find(".png") != std::string::npos) && compressedSize != 0) {
-            // Check if it's a DIVINITY compressed texture
-            if (std::memcmp(modFile.FileBytes.data(), "DIVINITY", 8) == 0) {
-                // This is a compressed texture, read the uncompressed size
-                std::copy(modFile.FileBytes.begin() + 8, modFile.FileBytes.begin() + 16, reinterpret_cast<std::byte*>(&uncompressedSize));
-
-                // Set the compressed texture data, skipping the DIVINITY header (16 bytes)
-                modFile.FileBytes = std::vector<std::byte>(modFile.FileBytes.begin() + 16, modFile.FileBytes.end());
-                compressedSize = modFile.FileBytes.size();
-                compressionMode = std::byte{2};
-
-                if (ProgramOptions::Verbose) {
-                    os << "\tSuccessfully set compressed texture data for file " << modFile.Name << '\n';
-                }
-            }
-            else if (ProgramOptions::CompressTextures) {
-                // Compress the texture
-                std::vector<std::byte> compressedData;
-
-                try {
-                    compressedData = Oodle::Compress(modFile.FileBytes);
-
-                    if (compressedData.empty()) {
-                        throw std::exception();
-                    }
-                }
-                catch (...) {
-                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to compress " << modFile.Name << '\n';
-                    continue;
-                }
-
-                modFile.FileBytes = compressedData;
-                compressedSize = compressedData.size();
-                compressionMode = std::byte{2};
-
-                if (ProgramOptions::Verbose) {
-                    os << "\tSuccessfully compressed texture file " << modFile.Name << '\n';
-                }
-            }
-        }
-
-        // Add the mode file data at the end of the data vector
-        size_t resourceFileSize = memoryMappedFile.Size;
-        size_t placement = 0x10 - (data.size() % 0x10) + 0x30;
-        uint64_t fileOffset = resourceFileSize + (data.size() - originalDataSize) + placement;
-        data.resize(data.size() + placement + modFile.FileBytes.size());
-        std::copy(modFile.FileBytes.begin(), modFile.FileBytes.end(), data.end() - modFile.FileBytes.size());
+        resourceContainer.AddResourceName(modFile.Name);
 
         // Add the asset type name id, if it's not found, use zero
         int64_t nameId = resourceContainer.GetResourceNameId(modFile.Name);
@@ -346,7 +373,7 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
             addedCount++;
         }
 
-        modFile.FileBytes.resize(0);
+        modFile.FileBytes.clear();
         newChunksCount++;
     }
 
@@ -397,6 +424,19 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
         std::copy(reinterpret_cast<std::byte*>(&newOffsetPlusDataAdd), reinterpret_cast<std::byte*>(&newOffsetPlusDataAdd) + 8, info.begin() + fileOffset);
     }
 
+    // Resize the container for the bigger tables, dropping the space reserved for data that wasn't added
+    size_t newContainerSize = resourceContainer.DataOffset + dataAdd + dataSize;
+
+    if (newContainerSize != memoryMappedFile.Size && !memoryMappedFile.ResizeFile(newContainerSize)) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to resize " << resourceContainer.Path << '\n';
+        return;
+    }
+
+    // Move the data section after the tables, the tables are rebuilt in front of it
+    if (dataAdd != 0) {
+        std::memmove(memoryMappedFile.Mem + resourceContainer.DataOffset + dataAdd, memoryMappedFile.Mem + resourceContainer.DataOffset, dataSize);
+    }
+
     // Rebuild the container now
     size_t pos = 0;
 
@@ -424,17 +464,6 @@ void AddChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceCo
     std::copy(idcl.begin(), idcl.end(), memoryMappedFile.Mem + pos);
     pos += idcl.size();
 
-    if (pos + data.size() > memoryMappedFile.Size) {
-        size_t newContainerSize = pos + data.size();
-
-        if (!memoryMappedFile.ResizeFile(newContainerSize)) {
-            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to resize " << resourceContainer.Path << '\n';
-            return;
-        }
-    }
-
-    std::copy(data.begin(), data.end(), memoryMappedFile.Mem + pos);
-
     if (addedCount != 0) {
         os << "Number of files added: " << Colors::Green << addedCount << " file(s) " << Colors::Reset << "in " << Colors::Yellow << resourceContainer.Path << Colors::Reset << "." << '\n';
     }
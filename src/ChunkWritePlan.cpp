@@ -0,0 +1,317 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include "Colors.hpp"
+#include "ProgramOptions.hpp"
+#include "ChunkWritePlan.hpp"
+
+// Appends smaller than this in total are copied on a single thread
+static constexpr size_t ParallelCopySize = 64 * 1024 * 1024;
+
+uint64_t ChunkWritePlan::ReadField(const uint64_t position) const
+{
+    uint64_t value;
+    std::memcpy(&value, ContainerFile.Mem + position, 8);
+    return value;
+}
+
+void ChunkWritePlan::WriteField(const uint64_t position, const uint64_t value)
+{
+    std::memcpy(ContainerFile.Mem + position, &value, 8);
+}
+
+bool ChunkWritePlan::Add(const size_t chunk, ResourceModFile& modFile,
+    const uint64_t compressedSize, const uint64_t uncompressedSize, const std::byte *compressionMode)
+{
+    if (ProgramOptions::SlowMode && !PlanInPlace(chunk, modFile.FileBytes.size(), compressedSize)) {
+        return false;
+    }
+
+    PlannedWrite& write = Writes.emplace_back();
+    write.Chunk = chunk;
+    write.Name = modFile.Name;
+    write.FileBytes = std::move(modFile.FileBytes);
+    write.CompressedSize = compressedSize;
+    write.UncompressedSize = uncompressedSize;
+
+    if (compressionMode != nullptr) {
+        write.CompressionMode = *compressionMode;
+    }
+
+    return true;
+}
+
+// Plan replacing the chunk's data where it is, as the writes planned before it left the container
+bool ChunkWritePlan::PlanInPlace(const size_t chunk, const uint64_t dataSize, const uint64_t compressedSize)
+{
+    if (Writes.empty()) {
+        PlannedSize = ContainerFile.Size;
+        Segments = { Segment{ContainerSegment, 0, PlannedSize} };
+        OffsetShifts.clear();
+        PlannedSizesZ.clear();
+    }
+
+    // The data moved with every chunk resized before this one
+    const ChunkTable& chunks = Container.Chunks;
+    uint64_t fileOffset = ReadField(chunks.FileOffsets[chunk]);
+
+    for (const auto& offsetShift : OffsetShifts) {
+        if (offsetShift.first < chunk) {
+            fileOffset += offsetShift.second;
+        }
+    }
+
+    auto plannedSizeZ = PlannedSizesZ.find(chunk);
+    uint64_t size = plannedSizeZ != PlannedSizesZ.end() ? plannedSizeZ->second : ReadField(chunks.FileOffsets[chunk] + 8);
+
+    // The chunk fields are written after the data is moved, so the data can't come before them
+    if (fileOffset < Container.DataOffset || fileOffset > PlannedSize || size > PlannedSize - fileOffset) {
+        return false;
+    }
+
+    // The old data is replaced by exactly the new data, nothing is left behind if it's shorter
+    std::vector<Segment> replacement;
+
+    if (dataSize != 0) {
+        replacement.push_back(Segment{DataSegment, 0, dataSize, Writes.size()});
+    }
+
+    Splice(fileOffset, size, replacement);
+
+    // If the size changed, everything after the data moves, and so does the data of every later chunk
+    if (dataSize != size) {
+        OffsetShifts.emplace_back(chunk, static_cast<int64_t>(dataSize - size));
+        PlannedSize += dataSize - size;
+    }
+
+    PlannedSizesZ[chunk] = compressedSize;
+    return true;
+}
+
+// Replace [position, position + length) of the planned container
+void ChunkWritePlan::Splice(const uint64_t position, const uint64_t length, const std::vector<Segment>& replacement)
+{
+    // Find the segment holding the position, splitting it there
+    size_t first = 0;
+    uint64_t segmentStart = 0;
+
+    while (first < Segments.size() && segmentStart + Segments[first].Length <= position) {
+        segmentStart += Segments[first].Length;
+        first++;
+    }
+
+    if (first < Segments.size() && segmentStart < position) {
+        Segment tail = Segments[first];
+        uint64_t headLength = position - segmentStart;
+        tail.Offset += headLength;
+        tail.Length -= headLength;
+        Segments[first].Length = headLength;
+        Segments.insert(Segments.begin() + ++first, tail);
+    }
+
+    // Remove the replaced bytes
+    size_t last = first;
+    uint64_t remaining = length;
+
+    while (remaining > 0 && last < Segments.size()) {
+        if (Segments[last].Length <= remaining) {
+            remaining -= Segments[last].Length;
+            last++;
+        }
+        else {
+            Segments[last].Offset += remaining;
+            Segments[last].Length -= remaining;
+            remaining = 0;
+        }
+    }
+
+    Segments.erase(Segments.begin() + first, Segments.begin() + last);
+    Segments.insert(Segments.begin() + first, replacement.begin(), replacement.end());
+}
+
+// Copy the data of the writes in [begin, end) into the container
+void ChunkWritePlan::CopyRange(std::byte *containerData, std::vector<PlannedWrite>& writes, const size_t begin, const size_t end)
+{
+    for (size_t i = begin; i < end; i++) {
+        writes[i].Written = writes[i].FileBytes.CopyTo(containerData + writes[i].DataOffset);
+        writes[i].FileBytes.clear();
+    }
+}
+
+// Append all the data at the end of the container
+void ChunkWritePlan::WriteAtEnd()
+{
+    // Lay the data out exactly like appending it one file at a time
+    size_t containerSize = ContainerFile.Size;
+    size_t totalSize = 0;
+
+    for (auto& write : Writes) {
+        size_t dataSectionLength = containerSize - Container.DataOffset;
+        size_t placement = 0x10 - (dataSectionLength % 0x10) + 0x30;
+        containerSize += write.FileBytes.size() + placement;
+        write.DataOffset = containerSize - write.FileBytes.size();
+        totalSize += write.FileBytes.size();
+    }
+
+    // The mapping moves when the container is resized, so it's only resized once for all the data
+    if (!ContainerFile.ResizeFile(containerSize)) {
+        return;
+    }
+
+    size_t rangeCount = 1;
+
+    if (Pool != nullptr && totalSize >= ParallelCopySize * 2) {
+        rangeCount = std::min({ Pool->ThreadCount(), totalSize / ParallelCopySize, Writes.size() });
+    }
+
+    // Split large batches between the pool's workers by size
+    TaskGroup copyTasks;
+    size_t submittedCount = 0;
+    size_t begin = 0;
+    size_t rangeSize = 0;
+
+    for (size_t i = 0; i < Writes.size() && rangeCount > 1; i++) {
+        rangeSize += Writes[i].FileBytes.size();
+
+        if (rangeSize >= totalSize / rangeCount && submittedCount < rangeCount - 1) {
+            Pool->Submit([this, begin, end = i + 1] { CopyRange(ContainerFile.Mem, Writes, begin, end); }, &copyTasks);
+            submittedCount++;
+            begin = i + 1;
+            rangeSize = 0;
+        }
+    }
+
+    CopyRange(ContainerFile.Mem, Writes, begin, Writes.size());
+
+    if (submittedCount > 0) {
+        Pool->Wait(copyTasks);
+    }
+
+    // Point the chunks at their new data
+    for (const auto& write : Writes) {
+        if (write.Written) {
+            WriteField(Container.Chunks.FileOffsets[write.Chunk], write.DataOffset);
+        }
+    }
+}
+
+// Rewrite the container with the data in place, in a single pass
+void ChunkWritePlan::WriteInPlace()
+{
+    if (PlannedSize > ContainerFile.Size && !ContainerFile.ResizeFile(PlannedSize)) {
+        return;
+    }
+
+    std::vector<uint64_t> positions(Segments.size());
+    uint64_t position = 0;
+
+    for (size_t i = 0; i < Segments.size(); i++) {
+        positions[i] = position;
+        position += Segments[i].Length;
+    }
+
+    // The container's bytes keep their order, so the ones moving towards the start are moved going from the start,
+    // and the ones moving towards the end going from the end, each before anything is written over them
+    for (size_t i = 0; i < Segments.size(); i++) {
+        if (Segments[i].Source == ContainerSegment && positions[i] < Segments[i].Offset) {
+            std::memmove(ContainerFile.Mem + positions[i], ContainerFile.Mem + Segments[i].Offset, Segments[i].Length);
+        }
+    }
+
+    for (size_t i = Segments.size(); i-- > 0;) {
+        if (Segments[i].Source == ContainerSegment && positions[i] > Segments[i].Offset) {
+            std::memmove(ContainerFile.Mem + positions[i], ContainerFile.Mem + Segments[i].Offset, Segments[i].Length);
+        }
+    }
+
+    // The mod data goes where the moved bytes were, straight from where it's stored
+    for (auto& write : Writes) {
+        write.Written = true;
+    }
+
+    for (size_t i = 0; i < Segments.size(); i++) {
+        if (Segments[i].Source == DataSegment) {
+            PlannedWrite& write = Writes[Segments[i].WriteIndex];
+            write.Written = write.FileBytes.CopyTo(ContainerFile.Mem + positions[i], Segments[i].Offset, Segments[i].Length) && write.Written;
+        }
+    }
+
+    // Drop the bytes left past the end if the container shrank, if that fails they're just never read
+    if (PlannedSize < ContainerFile.Size) {
+        ContainerFile.ResizeFile(PlannedSize);
+    }
+
+    // Move the data offsets of the chunks after each resized chunk, all at once
+    const ChunkTable& chunks = Container.Chunks;
+    std::sort(OffsetShifts.begin(), OffsetShifts.end());
+    int64_t offsetShift = 0;
+    size_t nextShift = 0;
+
+    for (size_t i = OffsetShifts.empty() ? chunks.size() : OffsetShifts[0].first + 1; i < chunks.size(); i++) {
+        while (nextShift < OffsetShifts.size() && OffsetShifts[nextShift].first < i) {
+            offsetShift += OffsetShifts[nextShift++].second;
+        }
+
+        WriteField(chunks.FileOffsets[i], ReadField(chunks.FileOffsets[i]) + offsetShift);
+    }
+
+    for (auto& write : Writes) {
+        write.FileBytes.clear();
+    }
+}
+
+// Write the planned data, returning how many of the files failed and adding their chunks to the given list
+size_t ChunkWritePlan::Write(std::stringstream& os, std::vector<size_t>& failedChunks)
+{
+    if (Writes.empty()) {
+        return 0;
+    }
+
+    if (ProgramOptions::SlowMode) {
+        WriteInPlace();
+    }
+    else {
+        WriteAtEnd();
+    }
+
+    // Replace the chunk sizes, in the order the data was planned
+    size_t failedCount = 0;
+    const ChunkTable& chunks = Container.Chunks;
+
+    for (const auto& write : Writes) {
+        if (!write.Written) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to set new mod data for " << write.Name << " in resource chunk." << '\n';
+            failedChunks.push_back(write.Chunk);
+            failedCount++;
+            continue;
+        }
+
+        WriteField(chunks.SizeOffset(write.Chunk), write.CompressedSize);
+        WriteField(chunks.SizeOffset(write.Chunk) + 8, write.UncompressedSize);
+
+        if (write.CompressionMode.has_value()) {
+            ContainerFile.Mem[chunks.SizeOffset(write.Chunk) + 0x30] = *write.CompressionMode;
+        }
+    }
+
+    Writes.clear();
+    Segments.clear();
+    return failedCount;
+}
@@ -24,17 +24,24 @@
 #include <thread>
 #include <filesystem>
 #include <mutex>
+#include <optional>
+#include <set>
 #include "Colors.hpp"
+#include "InjectionPipeline.hpp"
+#include "ListResourcesCache.hpp"
 #include "LoadModFiles.hpp"
 #include "LoadMods.hpp"
+#include "ModPackage.hpp"
 #include "OnlineSafety.hpp"
 #include "Oodle.hpp"
 #include "PackageMapSpecInfo.hpp"
 #include "ProgramOptions.hpp"
+#include "RepackContainers.hpp"
 #include "ResourceContainer.hpp"
 #include "ResourceData.hpp"
 #include "SoundContainer.hpp"
 #include "StreamDBContainer.hpp"
+#include "ThreadPool.hpp"
 #include "Utils.hpp"
 #include "PathToResource.hpp"
 
@@ -73,6 +80,10 @@ int main(int argc, char **argv)
         std::cout << "\t--online-safe - Only load online-safe mods.\n";
         std::cout << "\t--compress-textures - Compress texture files during the mod loading process.\n";
         std::cout << "\t--disable-multithreading - Disables multi-threaded mod loading.\n";
+        std::cout << "\t--jobs [count] - Sets the number of worker threads used to load mods (defaults to the number of CPU threads).\n";
+        std::cout << "\t--pack - Converts the zipped mods in 'Mods' folder to .emlpack packages, which are loaded instead of the zips, and exits.\n";
+        std::cout << "\t--repack [container names] - Rebuilds the given comma-separated .resources containers (or all of them) without the data their chunks don't use anymore, and exits.\n";
+        std::cout << "\t--max-memory [MB] - Limits how much mod data is kept in memory at once, injecting fewer containers in parallel if needed.\n";
         std::cout << "\t--redirectBlangContainer [container name] - Redirects the injection of EternalMod string mods to the specified container." << std::endl;
         return 1;
     }
@@ -98,7 +109,7 @@ int main(int argc, char **argv)
     // Parse rs_data
     std::map<uint64_t, ResourceDataEntry> resourceDataMap;
 
-    if (!ProgramOptions::ListResources) {
+    if (!ProgramOptions::ListResources && !ProgramOptions::PackMods && !ProgramOptions::RepackContainers) {
         std::string resourceDataFilePath = ProgramOptions::BasePath + "rs_data";
 
         if (fs::exists(resourceDataFilePath)) {
@@ -130,145 +141,270 @@ int main(int argc, char **argv)
             continue;
         }
 
-        if (file.path().extension() == ".zip" && file.path() == std::string(argv[1]) + SEPARATOR + "Mods" + SEPARATOR + file.path().filename().string()) {
+        bool isArchive = file.path().extension() == ".zip" || file.path().extension() == ".emlpack";
+
+        if (isArchive && file.path() == std::string(argv[1]) + SEPARATOR + "Mods" + SEPARATOR + file.path().filename().string()) {
             zippedMods.push_back(file.path().string());
         }
-        else if (file.path().extension() != ".zip") {
+        else if (!isArchive) {
             unzippedMods.push_back(file.path().string());
         }
     }
 
+    // Load packages instead of the zips they were converted from, unless the zip was updated since
+    auto isPackageOutdated = [](const fs::path& packagedMod) {
+        std::error_code ec;
+        fs::path zippedMod = fs::path(packagedMod).replace_extension(".zip");
+        return fs::exists(zippedMod, ec) && fs::last_write_time(zippedMod, ec) > fs::last_write_time(packagedMod, ec);
+    };
+
+    if (!ProgramOptions::PackMods) {
+        zippedMods.erase(std::remove_if(zippedMods.begin(), zippedMods.end(), [&](const std::string& zippedMod) {
+            fs::path modPath(zippedMod);
+
+            if (modPath.extension() == ".emlpack") {
+                if (isPackageOutdated(modPath)) {
+                    if (!ProgramOptions::ListResources) {
+                        std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Package " << zippedMod << " is older than its zip, loading the zip instead" << '\n';
+                    }
+
+                    return true;
+                }
+
+                return false;
+            }
+
+            fs::path packagedMod = modPath.replace_extension(".emlpack");
+            return fs::exists(packagedMod) && !isPackageOutdated(packagedMod);
+        }), zippedMods.end());
+    }
+
     // Get the resource container paths
     GetResourceContainerPathList();
 
     // Store all containers used by mods
-    std::vector<ResourceContainer> resourceContainerList;
-    std::vector<SoundContainer> soundContainerList;
-    std::vector<StreamDBContainer> streamDBContainerList;
+    ContainerRegistry<ResourceContainer> resourceContainers;
+    ContainerRegistry<SoundContainer> soundContainers;
+    ContainerRegistry<StreamDBContainer> streamDBContainers;
 
-    // Reserve enough space for all resource/sound containers
-    resourceContainerList.reserve(100);
-    soundContainerList.reserve(30);
-
-    // Load zipped mods
-    chrono::steady_clock::time_point zippedModsBegin = chrono::steady_clock::now();
+    // Create the worker pool used to load the mod files
+    std::unique_ptr<ThreadPool> threadPool;
 
     if (ProgramOptions::MultiThreading) {
-        std::vector<std::thread> zippedModLoadingThreads;
-        zippedModLoadingThreads.reserve(zippedMods.size());
+        threadPool = std::make_unique<ThreadPool>(ProgramOptions::Jobs != 0 ? ProgramOptions::Jobs : ThreadPool::GetDefaultThreadCount());
+    }
+
+    // Convert the zipped mods to packages and exit
+    if (ProgramOptions::PackMods) {
+        auto packZippedMod = [](const std::string& zippedMod) {
+            std::stringstream os;
+            ModPackage::Pack(zippedMod, fs::path(zippedMod).replace_extension(".emlpack").string(), os);
+
+            mtx.lock();
+            std::cout << os.rdbuf();
+            mtx.unlock();
+        };
 
         for (const auto& zippedMod : zippedMods) {
-            zippedModLoadingThreads.push_back(std::thread(LoadZippedMod, zippedMod, std::ref(resourceContainerList),
-                std::ref(soundContainerList), std::ref(streamDBContainerList), std::ref(notFoundContainers)));
+            if (fs::path(zippedMod).extension() != ".zip") {
+                continue;
+            }
+
+            if (threadPool != nullptr) {
+                threadPool->Submit([&, zippedMod] { packZippedMod(zippedMod); });
+            }
+            else {
+                packZippedMod(zippedMod);
+            }
         }
 
-        for (auto& thread : zippedModLoadingThreads) {
-            thread.join();
+        if (threadPool != nullptr) {
+            threadPool->Wait();
         }
+
+        std::cout.flush();
+        return 0;
     }
-    else {
-        for (const auto& zippedMod : zippedMods) {
-            LoadZippedMod(zippedMod, resourceContainerList, soundContainerList, streamDBContainerList, notFoundContainers);
+
+    // Repack the resource containers and exit
+    if (ProgramOptions::RepackContainers) {
+        std::vector<std::string> containerPaths;
+
+        if (ProgramOptions::RepackContainerNames.empty()) {
+            containerPaths = GetAllResourceContainerPaths();
+        }
+
+        for (const auto& containerName : ProgramOptions::RepackContainerNames) {
+            std::string containerPath = PathToResourceContainer(EndsWith(containerName, ".resources") ? containerName : containerName + ".resources");
+
+            if (containerPath.empty()) {
+                std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Resource container " << containerName << " was not found" << '\n';
+                continue;
+            }
+
+            if (std::find(containerPaths.begin(), containerPaths.end(), containerPath) == containerPaths.end()) {
+                containerPaths.push_back(containerPath);
+            }
         }
+
+        RepackContainers(containerPaths, threadPool.get());
+        std::cout.flush();
+        return 0;
     }
 
-    chrono::steady_clock::time_point zippedModsEnd = chrono::steady_clock::now();
-    double zippedModsTime = chrono::duration_cast<chrono::microseconds>(zippedModsEnd - zippedModsBegin).count() / 1000000.0;
+    if (ProgramOptions::MaxMemory != 0) {
+        InitMemoryBudget(ProgramOptions::MaxMemory);
+    }
 
-    // Load unzipped mods
-    chrono::steady_clock::time_point unzippedModsBegin = chrono::steady_clock::now();
+    if (!ProgramOptions::ListResources) {
+        InitTocCache(ProgramOptions::BasePath + "EternalModLoader.toc");
+    }
 
-    std::atomic<size_t> unzippedModCount = 0;
-    std::map<size_t, std::vector<ResourceModFile>> resourceModFiles;
-    std::map<size_t, std::vector<SoundModFile>> soundModFiles;
-    std::map<size_t, std::vector<StreamDBModFile>> streamDBModFiles;
-    Mod globalLooseMod;
-    globalLooseMod.LoadPriority = INT_MIN;
+    // Inject containers on the pool while the other mods are still loading
+    InjectionPipeline injectionPipeline(resourceContainers, soundContainers, resourceDataMap, threadPool.get());
+    std::vector<std::optional<std::set<std::string>>> zippedModContainerNames(zippedMods.size());
+    std::set<std::string> unzippedModContainerNames;
+    bool pipelineMods = ProgramOptions::MultiThreading && !ProgramOptions::ListResources;
 
-    if (ProgramOptions::MultiThreading) {
-        std::vector<std::thread> unzippedModLoadingThreads;
-        unzippedModLoadingThreads.reserve(unzippedMods.size());
-
-        for (const auto& unzippedMod : unzippedMods) {
-            unzippedModLoadingThreads.push_back(std::thread(LoadUnzippedMod, unzippedMod, std::ref(globalLooseMod),
-                std::ref(unzippedModCount), std::ref(resourceModFiles), std::ref(soundModFiles), std::ref(streamDBModFiles),
-                std::ref(resourceContainerList), std::ref(soundContainerList), std::ref(streamDBContainerList),
-                std::ref(notFoundContainers)));
+    if (pipelineMods) {
+        // Read every mod's central directory first, so each container knows which mods it waits for
+        for (size_t i = 0; i < zippedMods.size(); i++) {
+            threadPool->Submit([&, i] { zippedModContainerNames[i] = GetModContainerNames(zippedMods[i]); });
         }
 
-        for (auto& thread : unzippedModLoadingThreads) {
-            thread.join();
-        }
+        threadPool->Wait();
+        unzippedModContainerNames = GetUnzippedModContainerNames(unzippedMods);
+
+        // Don't start any container early if a mod couldn't be read
+        pipelineMods = std::all_of(zippedModContainerNames.begin(), zippedModContainerNames.end(),
+            [](const std::optional<std::set<std::string>>& containerNames) { return containerNames.has_value(); });
     }
-    else {
-        for (const auto& unzippedMod : unzippedMods) {
-            LoadUnzippedMod(unzippedMod, globalLooseMod, unzippedModCount, resourceModFiles, soundModFiles,
-                streamDBModFiles, resourceContainerList, soundContainerList, streamDBContainerList, notFoundContainers);
+
+    if (pipelineMods) {
+        for (const auto& containerNames : zippedModContainerNames) {
+            injectionPipeline.AddSource(*containerNames);
         }
-    }
 
-    // Check if the unzipped mods are safe for online play
-    if (!IsModSafeForOnline(resourceModFiles)) {
-        // Mods are not safe for online
-        // Check if they should be loaded
-        ProgramOptions::AreModsSafeForOnline = false;
-        globalLooseMod.IsSafeForOnline = false;
+        injectionPipeline.AddSource(unzippedModContainerNames);
 
+        // The online disabler changes these containers once all mods are loaded, so they can't start early
         if (!ProgramOptions::LoadOnlineSafeModsOnly) {
-            // Inject online disabler mods
-            for (const auto& resourceMod : resourceModFiles) {
-                ResourceContainer& resourceContainer = resourceContainerList[resourceMod.first];
-                resourceContainer.ModFileList.insert(resourceContainer.ModFileList.end(), resourceMod.second.begin(), resourceMod.second.end());
-            }
+            auto multiplayerDisablerMods = std::make_shared<std::vector<ResourceModFile>>(GetMultiplayerDisablerMods());
 
-            for (const auto& soundMod : soundModFiles) {
-                SoundContainer& soundContainer = soundContainerList[soundMod.first];
-                soundContainer.ModFileList.insert(soundContainer.ModFileList.end(), soundMod.second.begin(), soundMod.second.end());
-            }
+            injectionPipeline.HoldBack = [multiplayerDisablerMods](const ResourceContainer& resourceContainer) {
+                for (const auto& disablerModFile : *multiplayerDisablerMods) {
+                    if (disablerModFile.ResourceName == resourceContainer.Name) {
+                        return true;
+                    }
 
-            for (const auto& streamDBMod : streamDBModFiles) {
-                auto& streamDBContainer = streamDBContainerList[streamDBMod.first];
-                streamDBContainer.ModFiles.insert(streamDBContainer.ModFiles.end(), streamDBMod.second.begin(), streamDBMod.second.end());
-            }
+                    if (disablerModFile.IsBlangJson || disablerModFile.IsAssetsInfoJson) {
+                        continue;
+                    }
+
+                    for (const auto& modFile : resourceContainer.ModFileList) {
+                        if (modFile.Name == disablerModFile.Name) {
+                            return true;
+                        }
+                    }
+                }
+
+                return false;
+            };
         }
     }
-    else {
-        // Inject mods
-        for (const auto& resourceMod : resourceModFiles) {
-            ResourceContainer& resourceContainer = resourceContainerList[resourceMod.first];
-            resourceContainer.ModFileList.insert(resourceContainer.ModFileList.end(), resourceMod.second.begin(), resourceMod.second.end());
-        }
 
-        for (const auto& soundMod : soundModFiles) {
-            SoundContainer& soundContainer = soundContainerList[soundMod.first];
-            soundContainer.ModFileList.insert(soundContainer.ModFileList.end(), soundMod.second.begin(), soundMod.second.end());
+    // Load zipped mods
+    chrono::steady_clock::time_point modFilesBegin = chrono::steady_clock::now();
+
+    // Zips are listed from summaries cached between runs
+    std::unique_ptr<ListResourcesCache> listResourcesCache;
+    ListedResources listedResources;
+
+    if (ProgramOptions::ListResources) {
+        listResourcesCache = std::make_unique<ListResourcesCache>(ProgramOptions::BasePath + "EternalModLoader.listres");
+    }
+
+    auto loadZippedMod = [&](const std::string& zippedMod) {
+        if (listResourcesCache != nullptr && fs::path(zippedMod).extension() == ".zip") {
+            ListZippedMod(zippedMod, *listResourcesCache, listedResources, resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
+        }
+        else if (fs::path(zippedMod).extension() == ".emlpack") {
+            LoadPackagedMod(zippedMod, resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
+        }
+        else {
+            LoadZippedMod(zippedMod, threadPool.get(), resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
         }
+    };
 
-        for (const auto& streamDBMod : streamDBModFiles) {
-            auto& streamDBContainer = streamDBContainerList[streamDBMod.first];
-            streamDBContainer.ModFiles.insert(streamDBContainer.ModFiles.end(), streamDBMod.second.begin(), streamDBMod.second.end());
+    StagedModFiles looseModFiles;
+    auto globalLooseMod = std::make_shared<Mod>();
+    globalLooseMod->LoadPriority = INT_MIN;
+
+    if (pipelineMods) {
+        // Each mod starts the containers it was the last one waited for by
+        TaskGroup loadingTasks;
+
+        for (size_t i = 0; i < zippedMods.size(); i++) {
+            threadPool->Submit([&, i] {
+                loadZippedMod(zippedMods[i]);
+                injectionPipeline.SourceLoaded(*zippedModContainerNames[i]);
+            }, &loadingTasks);
         }
+
+        // Load unzipped mods alongside them
+        threadPool->Submit([&] {
+            LoadUnzippedMods(unzippedMods, threadPool.get(), globalLooseMod, looseModFiles,
+                resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
+            AddLooseModFiles(looseModFiles, *globalLooseMod);
+            injectionPipeline.SourceLoaded(unzippedModContainerNames);
+        }, &loadingTasks);
+
+        threadPool->Wait(loadingTasks);
     }
+    else {
+        if (ProgramOptions::MultiThreading) {
+            for (const auto& zippedMod : zippedMods) {
+                threadPool->Submit([&, zippedMod] { loadZippedMod(zippedMod); });
+            }
 
-    if (unzippedModCount > 0 && !ProgramOptions::ListResources) {
-        if (ProgramOptions::LoadOnlineSafeModsOnly && !globalLooseMod.IsSafeForOnline) {
-            std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Loose mod files are not safe for public matchmaking, skipping" << '\n';
+            threadPool->Wait();
         }
         else {
-            std::cout << "Found " << Colors::Blue << unzippedModCount << " file(s) " << Colors::Reset << "in " << Colors::Yellow << "'Mods' " << Colors::Reset << "folder..." << '\n';
-
-            if (!globalLooseMod.IsSafeForOnline) {
-                std::cout << Colors::Yellow << "WARNING: Loose mod files are not safe for online play, public matchmaking will be disabled" << Colors::Reset << '\n';
+            for (const auto& zippedMod : zippedMods) {
+                loadZippedMod(zippedMod);
             }
         }
+
+        // Load unzipped mods
+        LoadUnzippedMods(unzippedMods, threadPool.get(), globalLooseMod, looseModFiles,
+            resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
+        AddLooseModFiles(looseModFiles, *globalLooseMod);
+    }
+
+    chrono::steady_clock::time_point modFilesEnd = chrono::steady_clock::now();
+    double modFilesTime = chrono::duration_cast<chrono::microseconds>(modFilesEnd - modFilesBegin).count() / 1000000.0;
+
+    // The containers started early still view the registries, so they're finished before taking them out
+    chrono::steady_clock::time_point modLoadingBegin = modFilesEnd;
+
+    if (pipelineMods) {
+        injectionPipeline.Wait();
     }
 
-    chrono::steady_clock::time_point unzippedModsEnd = chrono::steady_clock::now();
-    double unzippedModsTime = chrono::duration_cast<chrono::microseconds>(unzippedModsEnd - unzippedModsBegin).count() / 1000000.0;
+    // Take the containers out of the registries, in the order mods first used them
+    std::vector<ResourceContainer> resourceContainerList = resourceContainers.TakeContainers();
+    std::vector<SoundContainer> soundContainerList = soundContainers.TakeContainers();
+    std::vector<StreamDBContainer> streamDBContainerList = streamDBContainers.TakeContainers();
+
+    // The containers injected early are done
+    resourceContainerList.erase(std::remove_if(resourceContainerList.begin(), resourceContainerList.end(),
+        [&](const ResourceContainer& resourceContainer) { return injectionPipeline.WasStarted(resourceContainer.Name); }), resourceContainerList.end());
+    soundContainerList.erase(std::remove_if(soundContainerList.begin(), soundContainerList.end(),
+        [&](const SoundContainer& soundContainer) { return injectionPipeline.WasStarted(soundContainer.Name); }), soundContainerList.end());
 
     // Remove resources from the list if they have no mods to load
     for (auto i = static_cast<ssize_t>(resourceContainerList.size()) - 1; i >= 0; i--) {
-        if (resourceContainerList[i].ModFileList.empty()) {
+        if (resourceContainerList[i].ModFileList.empty() && listedResources.ResourceContainers.count(resourceContainerList[i].Name) == 0) {
             resourceContainerList.erase(resourceContainerList.begin() + i);
         }
     }
@@ -293,25 +429,30 @@ int main(int argc, char **argv)
             for (auto& resourceContainer : resourceContainerList) {
                 if (modFile.ResourceName == resourceContainer.Name) {
                     found = true;
-                    resourceContainer.ModFileList.push_back(modFile);
+                    resourceContainer.ModFileList.push_back(std::move(modFile));
                     break;
                 }
             }
 
             if (!found) {
                 ResourceContainer resourceContainer(modFile.ResourceName, PathToResourceContainer(modFile.ResourceName + ".resources"));
-                resourceContainer.ModFileList.push_back(modFile);
-                resourceContainerList.push_back(resourceContainer);
+                resourceContainer.ModFileList.push_back(std::move(modFile));
+                resourceContainerList.push_back(std::move(resourceContainer));
             }
         }
     }
 
     // List resources to be modified and exit
     if (ProgramOptions::ListResources) {
+        listResourcesCache->Save();
+
         // Print the packagemapspec path if the modded streamdb was added
-        bool printPackageMapSpecJsonPath = std::find_if(streamDBContainerList.begin(), streamDBContainerList.end(),
+        bool printPackageMapSpecJsonPath = listedResources.ModifiesPackageMapSpec || std::find_if(streamDBContainerList.begin(), streamDBContainerList.end(),
             [](const StreamDBContainer& streamDBContainer) { return streamDBContainer.Name == "EternalMod.streamdb"; }) != streamDBContainerList.end();
 
+        // Files named like the multiplayer disabler's are replaced by it
+        bool isMultiplayerDisabled = !ProgramOptions::AreModsSafeForOnline && !ProgramOptions::LoadOnlineSafeModsOnly;
+
         for (auto& resourceContainer : resourceContainerList) {
             if (resourceContainer.Path.empty()) {
                 continue;
@@ -319,6 +460,14 @@ int main(int argc, char **argv)
 
             bool shouldListResource = false;
 
+            // Zipped mods listed from their summaries don't load their files into the container
+            auto listedContainer = listedResources.ResourceContainers.find(resourceContainer.Name);
+
+            if (listedContainer != listedResources.ResourceContainers.end()) {
+                shouldListResource = listedContainer->second.ModifiesMaps
+                    || (listedContainer->second.HasModFiles && !(listedContainer->second.HasOnlyDisablerFiles && isMultiplayerDisabled));
+            }
+
             for (auto& modFile : resourceContainer.ModFileList) {
                 if (!modFile.IsAssetsInfoJson) {
                     shouldListResource = true;
@@ -390,63 +539,51 @@ int main(int argc, char **argv)
 
     std::cout.flush();
 
-    // Set buffer for file i/o
-    int bufferSize = 4096;
-
-    try {
-        bufferSize = GetClusterSize();
-
-        if (bufferSize == -1) {
-            throw std::exception();
-        }
-    }
-    catch (...) {
-        std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Error while determining the optimal buffer size, using 4096 as the default." << std::endl;
-    }
-
-    auto buffer = std::make_unique<std::byte[]>(bufferSize);
-
     // Load mods
-    chrono::steady_clock::time_point modLoadingBegin = chrono::steady_clock::now();
-
-    InitStringStreams(resourceContainerList.size() + soundContainerList.size() + streamDBContainerList.size());
-
     if (ProgramOptions::MultiThreading) {
-        std::vector<std::thread> modLoadingThreads;
-        modLoadingThreads.reserve(resourceContainerList.size() + soundContainerList.size() + streamDBContainerList.size());
+        // Inject every container on the pool, so no more than --jobs threads do the work
+        TaskGroup injectionTasks;
 
         for (auto& resourceContainer : resourceContainerList) {
-            modLoadingThreads.push_back(std::thread(LoadResourceMods, std::ref(resourceContainer),
-                std::ref(resourceDataMap), std::ref(buffer), bufferSize));
+            threadPool->Submit([&, &os = NewStringStream()] {
+                LoadResourceMods(resourceContainer, resourceDataMap, threadPool.get(), os);
+            }, &injectionTasks);
         }
 
         for (auto& soundContainer : soundContainerList) {
-            modLoadingThreads.push_back(std::thread(LoadSoundMods, std::ref(soundContainer)));
+            threadPool->Submit([&, &os = NewStringStream()] { LoadSoundMods(soundContainer, os); }, &injectionTasks);
         }
 
         for (auto& streamDBContainer : streamDBContainerList) {
-            modLoadingThreads.push_back(std::thread(LoadStreamDBMods, std::ref(streamDBContainer), std::ref(streamDBContainerList)));
+            threadPool->Submit([&, &os = NewStringStream()] { LoadStreamDBMods(streamDBContainer, os); }, &injectionTasks);
         }
 
-        for (size_t i = 0; i < modLoadingThreads.size(); i++) {
-            modLoadingThreads[i].join();
-            OutputStringStream(i);
-        }
+        threadPool->Wait(injectionTasks);
+        OutputStringStreams();
     }
     else {
         for (auto& resourceContainer : resourceContainerList) {
-            LoadResourceMods(resourceContainer, resourceDataMap, buffer, bufferSize);
+            LoadResourceMods(resourceContainer, resourceDataMap, nullptr, NewStringStream());
         }
 
         for (auto& soundContainer : soundContainerList) {
-            LoadSoundMods(soundContainer);
+            LoadSoundMods(soundContainer, NewStringStream());
         }
 
         for (auto& streamDBContainer : streamDBContainerList) {
-            LoadStreamDBMods(streamDBContainer, streamDBContainerList);
+            LoadStreamDBMods(streamDBContainer, NewStringStream());
         }
     }
 
+    // Leave the streamdb files that couldn't be built out of the package map spec
+    streamDBContainerList.erase(std::remove_if(streamDBContainerList.begin(), streamDBContainerList.end(),
+        [](const StreamDBContainer& streamDBContainer) { return streamDBContainer.BuildFailed; }), streamDBContainerList.end());
+
+    // Keep the tables of contents of the containers read for the next run
+    // The containers may view the old cache, so they're released first
+    resourceContainerList.clear();
+    SaveTocCache();
+
     // Modify PackageMapSpec JSON file in disk
     if (!PackageMapSpecInfo::ModifyPackageMapSpec(ProgramOptions::BasePath, streamDBContainerList)) {
         std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to write " << PackageMapSpecInfo::PackageMapSpecPath << std::endl;
@@ -460,12 +597,12 @@ int main(int argc, char **argv)
     double modLoadingTime = chrono::duration_cast<chrono::microseconds>(modLoadingEnd - modLoadingBegin).count() / 1000000.0;
 
     if (ProgramOptions::Verbose) {
-        std::cout << Colors::Green << "Zipped mods loaded in " << zippedModsTime << " seconds.\n";
-        std::cout << "Unzipped mods loaded in " << unzippedModsTime << " seconds.\n";
+        std::cout << Colors::Green << "Mod files loaded in " << modFilesTime << " seconds.\n";
         std::cout << "Injection finished in " << modLoadingTime << " seconds.\n";
+        std::cout << "Injected " << ModFileBytes::InjectedBytes << " bytes of mod file data, " << ModFileBytes::CopiedBytes << " of them copied.\n";
     }
 
-    std::cout << Colors::Green << "Total time taken: " << zippedModsTime + unzippedModsTime + modLoadingTime << " seconds." << Colors::Reset << std::endl;
+    std::cout << Colors::Green << "Total time taken: " << modFilesTime + modLoadingTime << " seconds." << Colors::Reset << std::endl;
 
     // Exit the program with error code 0
     return 0;
@@ -18,36 +18,7 @@
 
 #include "GetObject.hpp"
 
-ssize_t GetResourceContainer(const std::string& resourceContainerName, std::vector<ResourceContainer>& resourceContainerList)
+ssize_t GetChunk(const std::string_view name, const ResourceContainer& resourceContainer)
 {
-    for (size_t i = 0; i < resourceContainerList.size(); i++) {
-        if (resourceContainerList[i].Name == resourceContainerName) {
-            return i;
-        }
-    }
-
-    return -1;
-}
-
-ssize_t GetSoundContainer(const std::string& soundContainerName, std::vector<SoundContainer>& soundContainerList)
-{
-    for (size_t i = 0; i < soundContainerList.size(); i++) {
-        if (soundContainerList[i].Name == soundContainerName) {
-            return i;
-        }
-    }
-
-    return -1;
-}
-
-ResourceChunk *GetChunk(const std::string name, ResourceContainer& resourceContainer)
-{
-    for (auto& chunk : resourceContainer.ChunkList) {
-        if (chunk.ResourceName.FullFileName == name
-            || chunk.ResourceName.NormalizedFileName == name) {
-                return &chunk;
-        }
-    }
-
-    return nullptr;
+    return resourceContainer.ChunkIndex.find(name);
 }
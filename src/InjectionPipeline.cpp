@@ -0,0 +1,70 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "LoadMods.hpp"
+#include "InjectionPipeline.hpp"
+
+// Count a mod that will load files into the given containers
+void InjectionPipeline::AddSource(const std::set<std::string>& containerNames)
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    for (const auto& containerName : containerNames) {
+        PendingSources[containerName]++;
+    }
+}
+
+// Start the containers that aren't waiting for any other mod
+void InjectionPipeline::SourceLoaded(const std::set<std::string>& containerNames)
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    for (const auto& containerName : containerNames) {
+        auto pendingSources = PendingSources.find(containerName);
+
+        if (pendingSources == PendingSources.end() || --pendingSources->second != 0) {
+            continue;
+        }
+
+        // No mod will touch the container again, so it's safe to inject it now
+        if (ResourceContainer *resourceContainer = ResourceContainers.Find(containerName)) {
+            if (resourceContainer->ModFileList.empty() || (HoldBack && HoldBack(*resourceContainer))) {
+                continue;
+            }
+
+            StartedContainers.insert(containerName);
+            Pool->Submit([this, resourceContainer, &os = NewStringStream()] {
+                LoadResourceMods(*resourceContainer, ResourceDataMap, Pool, os);
+            }, &InjectionTasks);
+        }
+        else if (SoundContainer *soundContainer = SoundContainers.Find(containerName)) {
+            if (soundContainer->ModFileList.empty()) {
+                continue;
+            }
+
+            StartedContainers.insert(containerName);
+            Pool->Submit([soundContainer, &os = NewStringStream()] { LoadSoundMods(*soundContainer, os); }, &InjectionTasks);
+        }
+    }
+}
+
+// Wait for the containers started so far
+void InjectionPipeline::Wait()
+{
+    Pool->Wait(InjectionTasks);
+}
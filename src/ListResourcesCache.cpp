@@ -0,0 +1,432 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include "AssetsInfo.hpp"
+#include "Colors.hpp"
+#include "MemoryMappedFile.hpp"
+#include "OnlineSafety.hpp"
+#include "Utils.hpp"
+#include "ListResourcesCache.hpp"
+#include "miniz/miniz.h"
+
+namespace fs = std::filesystem;
+
+extern std::mutex mtx;
+
+// Cache layout
+const char CacheMagic[8] = { 'E', 'M', 'L', 'L', 'I', 'S', 'T', '\0' };
+
+// Zip end of central directory record
+const uint32_t EndOfCentralDirectorySignature = 0x06054B50;
+const size_t EndOfCentralDirectorySize = 22;
+const size_t CentralDirectoryReadSize = EndOfCentralDirectorySize + 0xFFFF;  // Enough to find the record after the longest zip comment
+
+template<typename T>
+static void WriteValue(std::vector<std::byte>& bytes, const T value)
+{
+    bytes.insert(bytes.end(), reinterpret_cast<const std::byte*>(&value), reinterpret_cast<const std::byte*>(&value) + sizeof(T));
+}
+
+static void WriteString(std::vector<std::byte>& bytes, const std::string& string)
+{
+    WriteValue<uint32_t>(bytes, string.size());
+    bytes.insert(bytes.end(), reinterpret_cast<const std::byte*>(string.data()), reinterpret_cast<const std::byte*>(string.data()) + string.size());
+}
+
+// Read a value, throwing if it's out of bounds
+template<typename T>
+static T ReadValue(const std::byte *data, const size_t size, size_t& pos)
+{
+    if (pos > size || sizeof(T) > size - pos) {
+        throw std::exception();
+    }
+
+    T value;
+    std::copy(data + pos, data + pos + sizeof(T), reinterpret_cast<std::byte*>(&value));
+    pos += sizeof(T);
+    return value;
+}
+
+static std::string ReadString(const std::byte *data, const size_t size, size_t& pos)
+{
+    auto length = ReadValue<uint32_t>(data, size, pos);
+
+    if (length > size - pos) {
+        throw std::exception();
+    }
+
+    std::string string(reinterpret_cast<const char*>(data) + pos, length);
+    pos += length;
+    return string;
+}
+
+// Read a block of the file at the given offset
+static bool ReadFileBlock(FILE *file, const uint64_t offset, std::vector<std::byte>& bytes)
+{
+    // long is 32-bit on Windows, the 64-bit seek is needed for zips over 2 GB
+#ifdef _WIN32
+    bool success = _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    bool success = fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+
+    return success && fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+}
+
+// Checksum the zip's central directory, reading only the end of the file and the directory itself
+static std::optional<uint32_t> GetCentralDirectoryCrc(const std::string& zippedMod, const uint64_t zipSize)
+{
+    if (zipSize < EndOfCentralDirectorySize) {
+        return std::nullopt;
+    }
+
+    FILE *zipFile = fopen(zippedMod.c_str(), "rb");
+
+    if (zipFile == nullptr) {
+        return std::nullopt;
+    }
+
+    // Read the end of the file unbuffered, it holds the whole central directory of most mods
+    setvbuf(zipFile, nullptr, _IONBF, 0);
+    std::vector<std::byte> tail(std::min<uint64_t>(zipSize, CentralDirectoryReadSize));
+    uint64_t tailOffset = zipSize - tail.size();
+
+    if (!ReadFileBlock(zipFile, tailOffset, tail)) {
+        fclose(zipFile);
+        return std::nullopt;
+    }
+
+    // Find the end of central directory record, after the zip comment if there's one
+    size_t recordOffset = SIZE_MAX;
+
+    for (size_t i = tail.size() - EndOfCentralDirectorySize + 1; i-- > 0;) {
+        size_t pos = i;
+
+        if (ReadValue<uint32_t>(tail.data(), tail.size(), pos) == EndOfCentralDirectorySignature) {
+            recordOffset = i;
+            break;
+        }
+    }
+
+    if (recordOffset == SIZE_MAX) {
+        fclose(zipFile);
+        return std::nullopt;
+    }
+
+    size_t pos = recordOffset + 12;
+    auto centralDirectorySize = ReadValue<uint32_t>(tail.data(), tail.size(), pos);
+    auto centralDirectoryOffset = ReadValue<uint32_t>(tail.data(), tail.size(), pos);
+
+    // Zip64 archives aren't cached
+    if (centralDirectoryOffset == 0xFFFFFFFF || static_cast<uint64_t>(centralDirectoryOffset) + centralDirectorySize > zipSize) {
+        fclose(zipFile);
+        return std::nullopt;
+    }
+
+    // Only read the directory again if it didn't fit in the end of the file
+    const std::byte *centralDirectory = tail.data() + (centralDirectoryOffset - tailOffset);
+
+    if (centralDirectoryOffset < tailOffset) {
+        tail.resize(centralDirectorySize);
+        centralDirectory = tail.data();
+
+        if (!ReadFileBlock(zipFile, centralDirectoryOffset, tail)) {
+            fclose(zipFile);
+            return std::nullopt;
+        }
+    }
+
+    fclose(zipFile);
+    return static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(centralDirectory), centralDirectorySize));
+}
+
+// Sort a zipped mod's files by container, only inflating its assets info JSONs
+static bool SummarizeZippedMod(const std::string& zippedMod, ArchiveSummary& summary)
+{
+    std::unique_ptr<MemoryMappedFile> modArchive;
+
+    try {
+        modArchive = std::make_unique<MemoryMappedFile>(zippedMod, true);
+    }
+    catch (...) {
+        return false;
+    }
+
+    mz_zip_archive modZip;
+    mz_zip_zero_struct(&modZip);
+
+    if (!mz_zip_reader_init_mem(&modZip, modArchive->Mem, modArchive->Size, MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY)) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < modZip.m_total_files; i++) {
+        unsigned int zipEntryNameSize = mz_zip_reader_get_filename(&modZip, i, nullptr, 0);
+        auto zipEntryNameBuffer = std::make_unique<char[]>(zipEntryNameSize);
+
+        if (mz_zip_reader_get_filename(&modZip, i, zipEntryNameBuffer.get(), zipEntryNameSize) != zipEntryNameSize) {
+            mz_zip_reader_end(&modZip);
+            return false;
+        }
+
+        std::string zipEntryName(zipEntryNameBuffer.get());
+
+        // Skip directories
+        if (zipEntryName.empty() || zipEntryName.back() == '/') {
+            continue;
+        }
+
+        std::vector<std::string> modFilePathParts = SplitString(zipEntryName, '/');
+
+        if (modFilePathParts.size() < 2) {
+            continue;
+        }
+
+        std::string resourceName = modFilePathParts[0];
+        std::string modFileName = zipEntryName;
+
+        // Old mods compatibility
+        if (ToLower(resourceName) == "generated") {
+            resourceName = "gameresources";
+        }
+        else {
+            // Remove the resource name from the name
+            modFileName = zipEntryName.substr(resourceName.size() + 1);
+        }
+
+        uint32_t flags = 0;
+
+        if (modFilePathParts.size() > 2 && modFilePathParts[1] == "EternalMod" && modFilePathParts[2] == "strings") {
+            flags |= RedirectableArchiveContainer;
+        }
+
+        // Get the container's summary, in the order the mod first uses them
+        auto container = std::find_if(summary.Containers.begin(), summary.Containers.end(), [&](const ArchiveContainer& archiveContainer) {
+            return archiveContainer.ResourceName == resourceName && (archiveContainer.Flags & RedirectableArchiveContainer) == flags;
+        });
+
+        if (container == summary.Containers.end()) {
+            container = summary.Containers.insert(summary.Containers.end(), ArchiveContainer{resourceName, flags});
+        }
+
+        // Read the JSON files in 'assetsinfo' under 'EternalMod'
+        if (ToLower(modFilePathParts[1]) == "eternalmod") {
+            if (modFilePathParts.size() == 4
+            && ToLower(modFilePathParts[2]) == "assetsinfo"
+            && fs::path(modFilePathParts[3]).extension().string() == ".json") {
+                try {
+                    size_t assetsInfoJsonSize;
+                    char *assetsInfoJsonData = static_cast<char*>(mz_zip_reader_extract_to_heap(&modZip, i, &assetsInfoJsonSize, 0));
+
+                    if (assetsInfoJsonData == nullptr) {
+                        throw std::exception();
+                    }
+
+                    std::string assetsInfoJson(assetsInfoJsonData, assetsInfoJsonSize);
+                    free(assetsInfoJsonData);
+
+                    AssetsInfo assetsInfo(assetsInfoJson);
+                    container->Flags |= AssetsInfoArchiveContainer;
+
+                    if (!assetsInfo.Assets.empty() || !assetsInfo.Layers.empty() || !assetsInfo.Maps.empty()) {
+                        container->Flags |= ModifiesMapsArchiveContainer;
+                    }
+
+                    if (!assetsInfo.Resources.empty()) {
+                        container->Flags |= ModifiesResourcesArchiveContainer;
+                    }
+                }
+                catch (...) {
+                    mtx.lock();
+                    std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod/assetsinfo/"
+                        << fs::path(modFileName).stem().string() << ".json" << '\n';
+                    mtx.unlock();
+                }
+
+                continue;
+            }
+            else if (modFilePathParts.size() != 4
+            || ToLower(modFilePathParts[2]) != "strings"
+            || fs::path(modFilePathParts[3]).extension().string() != ".json") {
+                continue;
+            }
+        }
+
+        // Keep a file the multiplayer disabler won't remove, if there's one
+        if (container->ModFileName.empty() || IsMultiplayerDisablerFile(container->ModFileName)) {
+            container->ModFileName = modFileName;
+        }
+
+        if (container->UnsafeModFileName.empty() && !IsModFileSafeForUnsafeResource(modFileName)) {
+            container->UnsafeModFileName = modFileName;
+        }
+    }
+
+    mz_zip_reader_end(&modZip);
+    return true;
+}
+
+ListResourcesCache::ListResourcesCache(const std::string& cachePath) : CachePath(cachePath)
+{
+    // Start with an empty cache if it can't be read
+    std::unique_ptr<MemoryMappedFile> cacheFile;
+
+    try {
+        if (!fs::exists(CachePath)) {
+            return;
+        }
+
+        cacheFile = std::make_unique<MemoryMappedFile>(CachePath, true);
+        const std::byte *data = cacheFile->Mem;
+        size_t size = cacheFile->Size;
+
+        if (size < sizeof(CacheMagic) || std::memcmp(data, CacheMagic, sizeof(CacheMagic)) != 0) {
+            throw std::exception();
+        }
+
+        size_t pos = sizeof(CacheMagic);
+
+        if (ReadValue<uint32_t>(data, size, pos) != LIST_RESOURCES_CACHE_VERSION) {
+            throw std::exception();
+        }
+
+        auto archiveCount = ReadValue<uint32_t>(data, size, pos);
+
+        for (uint32_t i = 0; i < archiveCount; i++) {
+            std::string zippedMod = ReadString(data, size, pos);
+            ArchiveSummary summary;
+            summary.Size = ReadValue<uint64_t>(data, size, pos);
+            summary.WriteTime = ReadValue<int64_t>(data, size, pos);
+            summary.CentralDirectoryCrc = ReadValue<uint32_t>(data, size, pos);
+            summary.Containers.resize(ReadValue<uint32_t>(data, size, pos));
+
+            for (auto& container : summary.Containers) {
+                container.ResourceName = ReadString(data, size, pos);
+                container.Flags = ReadValue<uint32_t>(data, size, pos);
+                container.ModFileName = ReadString(data, size, pos);
+                container.UnsafeModFileName = ReadString(data, size, pos);
+            }
+
+            Summaries[zippedMod] = std::move(summary);
+        }
+    }
+    catch (...) {
+        Summaries.clear();
+    }
+}
+
+// Get a copy of the archive's summary, as another mod's thread may replace the cached one while it's used
+std::optional<ArchiveSummary> ListResourcesCache::GetSummary(const std::string& zippedMod)
+{
+    ArchiveSummary summary;
+    std::error_code ec;
+
+    summary.Size = fs::file_size(zippedMod, ec);
+    summary.WriteTime = fs::last_write_time(zippedMod, ec).time_since_epoch().count();
+
+    if (ec) {
+        return std::nullopt;
+    }
+
+    auto centralDirectoryCrc = GetCentralDirectoryCrc(zippedMod, summary.Size);
+
+    // Use the cached summary if the archive is unchanged
+    if (centralDirectoryCrc.has_value()) {
+        summary.CentralDirectoryCrc = centralDirectoryCrc.value();
+        std::lock_guard<std::mutex> lock(Mutex);
+        auto cachedSummary = Summaries.find(zippedMod);
+
+        if (cachedSummary != Summaries.end() && cachedSummary->second.Size == summary.Size
+        && cachedSummary->second.WriteTime == summary.WriteTime && cachedSummary->second.CentralDirectoryCrc == summary.CentralDirectoryCrc) {
+            UsedArchives.insert(zippedMod);
+            return cachedSummary->second;
+        }
+    }
+
+    if (!SummarizeZippedMod(zippedMod, summary)) {
+        return std::nullopt;
+    }
+
+    // Archives that couldn't be checksummed are summarized every time, so they aren't kept in the cache
+    if (centralDirectoryCrc.has_value()) {
+        std::lock_guard<std::mutex> lock(Mutex);
+        UsedArchives.insert(zippedMod);
+        Summaries[zippedMod] = summary;
+        Modified = true;
+    }
+
+    return summary;
+}
+
+bool ListResourcesCache::Save()
+{
+    // Only rewrite the cache if an archive was added, changed or removed
+    if (!Modified && UsedArchives.size() == Summaries.size()) {
+        return true;
+    }
+
+    std::vector<std::byte> cacheBytes(reinterpret_cast<const std::byte*>(CacheMagic), reinterpret_cast<const std::byte*>(CacheMagic) + sizeof(CacheMagic));
+    WriteValue<uint32_t>(cacheBytes, LIST_RESOURCES_CACHE_VERSION);
+    WriteValue<uint32_t>(cacheBytes, UsedArchives.size());
+
+    for (const auto& zippedMod : UsedArchives) {
+        const auto& summary = Summaries[zippedMod];
+        WriteString(cacheBytes, zippedMod);
+        WriteValue<uint64_t>(cacheBytes, summary.Size);
+        WriteValue<int64_t>(cacheBytes, summary.WriteTime);
+        WriteValue<uint32_t>(cacheBytes, summary.CentralDirectoryCrc);
+        WriteValue<uint32_t>(cacheBytes, summary.Containers.size());
+
+        for (const auto& container : summary.Containers) {
+            WriteString(cacheBytes, container.ResourceName);
+            WriteValue<uint32_t>(cacheBytes, container.Flags);
+            WriteString(cacheBytes, container.ModFileName);
+            WriteString(cacheBytes, container.UnsafeModFileName);
+        }
+    }
+
+    // Write to a temporary file first, so an interrupted write can't leave a broken cache behind
+    std::string tempCachePath = CachePath + ".tmp";
+    FILE *cacheFile = fopen(tempCachePath.c_str(), "wb");
+
+    if (cacheFile == nullptr) {
+        return false;
+    }
+
+    bool failed = fwrite(cacheBytes.data(), 1, cacheBytes.size(), cacheFile) != cacheBytes.size();
+    failed |= fclose(cacheFile) != 0;
+
+    std::error_code ec;
+
+    if (!failed) {
+        fs::rename(tempCachePath, CachePath, ec);
+        failed = static_cast<bool>(ec);
+    }
+
+    if (failed) {
+        fs::remove(tempCachePath, ec);
+        return false;
+    }
+
+    return true;
+}
@@ -20,8 +20,13 @@
 #include <algorithm>
 #include <filesystem>
 #include <mutex>
+#include <optional>
+#include <set>
 #include "Colors.hpp"
-#include "GetObject.hpp"
+#include "ListResourcesCache.hpp"
+#include "MemoryBudget.hpp"
+#include "MemoryMappedFile.hpp"
+#include "ModPackage.hpp"
 #include "OnlineSafety.hpp"
 #include "PathToResource.hpp"
 #include "ProgramOptions.hpp"
@@ -32,59 +37,151 @@
 namespace fs = std::filesystem;
 
 extern std::mutex mtx;
+extern std::unique_ptr<MemoryBudget> ModDataBudget;
 
 // Supported sound file formats
 const std::vector<std::string> SupportedSoundFormats{ ".ogg", ".opus", ".wav", ".wem", ".flac", ".aiff", ".pcm" };
 
-void LoadZippedMod(std::string zippedMod,
-    std::vector<ResourceContainer>& resourceContainerList, std::vector<SoundContainer>& soundContainerList,
-    std::vector<StreamDBContainer>& streamDBContainerList, std::vector<std::string>& notFoundContainers)
+// Minimum number of zip entries worth loading on another thread
+const unsigned int MinZipEntriesPerTask = 256;
+
+// Number of loose mod files loaded by a single task
+const size_t LooseFilesPerTask = 64;
+
+// Move another set's mod files after these ones
+void StagedModFiles::Merge(StagedModFiles& other)
 {
-    size_t zippedModCount = 0;
-    std::vector<std::string> modFileNameList;
-    std::map<size_t, std::vector<ResourceModFile>> resourceModFiles;
-    std::map<size_t, std::vector<SoundModFile>> soundModFiles;
-    std::map<size_t, std::vector<StreamDBModFile>> streamDBModFiles;
+    Count += other.Count;
 
-    // Load zipped mod
-    mz_zip_archive modZip;
-    mz_zip_zero_struct(&modZip);
-    mz_zip_reader_init_file(&modZip, zippedMod.c_str(), 0);
+    for (auto& resourceMod : other.ResourceModFiles) {
+        auto& modFiles = ResourceModFiles[resourceMod.first];
+        modFiles.insert(modFiles.end(), std::make_move_iterator(resourceMod.second.begin()), std::make_move_iterator(resourceMod.second.end()));
+    }
 
-    Mod mod;
+    for (auto& soundMod : other.SoundModFiles) {
+        auto& modFiles = SoundModFiles[soundMod.first];
+        modFiles.insert(modFiles.end(), std::make_move_iterator(soundMod.second.begin()), std::make_move_iterator(soundMod.second.end()));
+    }
 
-    if (!ProgramOptions::ListResources) {
-        // Read the mod info from the EternalMod JSON if it exists
-        char *unzippedModJson;
-        size_t unzippedModJsonSize;
+    for (auto& streamDBMod : other.StreamDBModFiles) {
+        auto& modFiles = StreamDBModFiles[streamDBMod.first];
+        modFiles.insert(modFiles.end(), std::make_move_iterator(streamDBMod.second.begin()), std::make_move_iterator(streamDBMod.second.end()));
+    }
 
-        if ((unzippedModJson = static_cast<char*>(mz_zip_reader_extract_file_to_heap(&modZip, "EternalMod.json", &unzippedModJsonSize, 0))) != nullptr) {
-            std::string modJson(unzippedModJson, unzippedModJsonSize);
-            free(unzippedModJson);
+    NotFoundContainers.insert(NotFoundContainers.end(), other.NotFoundContainers.begin(), other.NotFoundContainers.end());
+    other = StagedModFiles();
+}
 
-            try {
-                // Try to parse the JSON
-                mod = Mod(modJson);
+// Get the offset of a zip entry's data in the mapped archive, 0 if it can't be read in place
+static size_t GetZipEntryDataOffset(const mz_zip_archive_file_stat& zipEntryStat, const MemoryMappedFile& modArchive)
+{
+    // Only stored and deflated, unencrypted entries can be read in place
+    if ((zipEntryStat.m_method != 0 && zipEntryStat.m_method != MZ_DEFLATED) || zipEntryStat.m_is_encrypted
+    || (zipEntryStat.m_method == 0 && zipEntryStat.m_comp_size != zipEntryStat.m_uncomp_size)) {
+        return 0;
+    }
 
-                // If the mod requires a higher mod loader version, print a warning and don't load the mod
-                if (mod.RequiredVersion > VERSION) {
-                    mtx.lock();
-                    std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Mod " << fs::path(zippedMod).filename().string() << " requires mod loader version "
-                        << mod.RequiredVersion << " but the current mod loader version is " << VERSION << ", skipping" << '\n';
-                    mtx.unlock();
-                    return;
-                }
-            }
-            catch (...) {
-                mtx.lock();
-                std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod.json - using defaults." << '\n';
-                mtx.unlock();
-            }
+    // Skip the local header to find the entry's data
+    uint64_t localHeaderOffset = zipEntryStat.m_local_header_ofs;
+
+    if (localHeaderOffset + 30 > modArchive.Size) {
+        return 0;
+    }
+
+    const std::byte *localHeader = modArchive.Mem + localHeaderOffset;
+    uint32_t signature = 0;
+    uint16_t fileNameLength = 0, extraFieldLength = 0;
+    std::copy(localHeader, localHeader + 4, reinterpret_cast<std::byte*>(&signature));
+    std::copy(localHeader + 26, localHeader + 28, reinterpret_cast<std::byte*>(&fileNameLength));
+    std::copy(localHeader + 28, localHeader + 30, reinterpret_cast<std::byte*>(&extraFieldLength));
+
+    if (signature != 0x04034B50) {
+        return 0;
+    }
+
+    uint64_t dataOffset = localHeaderOffset + 30 + fileNameLength + extraFieldLength;
+
+    if (dataOffset + zipEntryStat.m_comp_size > modArchive.Size) {
+        return 0;
+    }
+
+    return dataOffset;
+}
+
+// Extract a zip entry straight into a byte vector
+static bool ExtractZipEntry(mz_zip_archive& modZip, const unsigned int index, std::vector<std::byte>& bytes)
+{
+    mz_zip_archive_file_stat zipEntryStat;
+
+    if (!mz_zip_reader_file_stat(&modZip, index, &zipEntryStat)) {
+        return false;
+    }
+
+    bytes.resize(zipEntryStat.m_uncomp_size);
+    return mz_zip_reader_extract_to_mem(&modZip, index, bytes.data(), bytes.size(), 0);
+}
+
+// Get a zip entry's data, used in place from the mapped archive or inflated later if possible
+static bool GetZipEntryBytes(mz_zip_archive& modZip, const unsigned int index, const std::shared_ptr<MemoryMappedFile>& modArchive, ModFileBytes& fileBytes)
+{
+    mz_zip_archive_file_stat zipEntryStat;
+
+    if (!mz_zip_reader_file_stat(&modZip, index, &zipEntryStat)) {
+        return false;
+    }
+
+    size_t zipEntryDataOffset = GetZipEntryDataOffset(zipEntryStat, *modArchive);
+
+    if (zipEntryDataOffset != 0 && zipEntryStat.m_method == 0) {
+        // Stored entries are used straight from the mapped archive
+        fileBytes = ModFileBytes(modArchive, zipEntryDataOffset, zipEntryStat.m_uncomp_size);
+    }
+    else if (zipEntryDataOffset != 0) {
+        // Deflated entries are inflated later, straight into the container
+        fileBytes = ModFileBytes(modArchive, zipEntryDataOffset, zipEntryStat.m_comp_size,
+            zipEntryStat.m_uncomp_size, zipEntryStat.m_crc32);
+    }
+    else {
+        // Read the mod file to memory
+        std::vector<std::byte> unzippedEntry;
+
+        if (!ExtractZipEntry(modZip, index, unzippedEntry)) {
+            return false;
         }
+
+        fileBytes = std::move(unzippedEntry);
     }
 
-    // Iterate through the zip's files
-    for (unsigned int i = 0; i < modZip.m_total_files; i++) {
+    return true;
+}
+
+// Load the mod files in a range of zip entries
+// Get the container a mod file path will be loaded into, starting from the container name part
+static std::string GetModFileContainerName(const std::vector<std::string>& modFilePathParts, const size_t resourceNameIndex)
+{
+    std::string resourceName = modFilePathParts[resourceNameIndex];
+
+    // Old mods compatibility
+    if (ToLower(resourceName) == "generated") {
+        resourceName = "gameresources";
+    }
+
+    // Redirect .blang files to a different container if specified
+    if (!ProgramOptions::BlangFileContainerRedirect.empty() && modFilePathParts.size() > resourceNameIndex + 2
+    && modFilePathParts[resourceNameIndex + 1] == "EternalMod" && modFilePathParts[resourceNameIndex + 2] == "strings") {
+        resourceName = ProgramOptions::BlangFileContainerRedirect;
+    }
+
+    return resourceName;
+}
+
+static void LoadZippedModEntries(const std::string& zippedMod, const std::shared_ptr<const Mod>& mod, mz_zip_archive& modZip,
+    const std::shared_ptr<MemoryMappedFile>& modArchive, const unsigned int firstEntry, const unsigned int lastEntry,
+    StagedModFiles& zippedModFiles, ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers)
+{
+    // Iterate through the zip's files in the given range
+    for (unsigned int i = firstEntry; i < lastEntry; i++) {
         // Get the mod file's name
         unsigned int zipEntryNameSize = mz_zip_reader_get_filename(&modZip, i, nullptr, 0);
         auto zipEntryNameBuffer = std::make_unique<char[]>(zipEntryNameSize);
@@ -113,20 +210,11 @@ void LoadZippedMod(std::string zippedMod,
             continue;
         }
 
-        std::string resourceName = modFilePathParts[0];
-
-        // Old mods compatibility
-        if (ToLower(resourceName) == "generated") {
-            resourceName = "gameresources";
-        }
-        else {
-            // Remove the resource name from the name
-            modFileName = modFileName.substr(resourceName.size() + 1, modFileName.size() - resourceName.size() - 1);
-        }
+        std::string resourceName = GetModFileContainerName(modFilePathParts, 0);
 
-        // Redirect .blang files to a different container if specified
-        if (!ProgramOptions::BlangFileContainerRedirect.empty() && modFilePathParts[1] == "EternalMod" && modFilePathParts[2] == "strings") {
-            resourceName = ProgramOptions::BlangFileContainerRedirect;
+        // Remove the resource name from the name, old mods' files don't have one
+        if (ToLower(modFilePathParts[0]) != "generated") {
+            modFileName = modFileName.substr(modFilePathParts[0].size() + 1, modFileName.size() - modFilePathParts[0].size() - 1);
         }
 
         // Get path to resource file
@@ -159,54 +247,26 @@ void LoadZippedMod(std::string zippedMod,
 
         if (isStreamDBMod) {
             // Get the streamdb container info object, create it if it doesn't exist
-            mtx.lock();
-
-            auto x = std::find_if(streamDBContainerList.begin(), streamDBContainerList.end(),
-                [](const StreamDBContainer& streamDbContainer) { return streamDbContainer.Name == "EternalMod.streamdb"; });
-
-            if (x == streamDBContainerList.end()) {
-                streamDBContainerList.push_back(StreamDBContainer("EternalMod.streamdb", resourcePath));
-                x = streamDBContainerList.end() - 1;
-            }
-
-            auto streamDBContainerIndex = std::distance(streamDBContainerList.begin(), x);
-
-            mtx.unlock();
+            StreamDBContainer *streamDBContainer = &streamDBContainers.GetOrAdd("EternalMod.streamdb", resourcePath);
 
             if (!ProgramOptions::ListResources) {
                 // Load the streamdb mod
-                std::byte *unzippedEntry;
-                size_t unzippedEntrySize;
+                StreamDBModFile streamDBModFile(mod, fs::path(modFileName).filename().string());
 
-                if ((unzippedEntry = reinterpret_cast<std::byte*>(mz_zip_reader_extract_to_heap(&modZip, i, &unzippedEntrySize, 0))) == nullptr) {
+                if (!GetZipEntryBytes(modZip, i, modArchive, streamDBModFile.FileData)) {
                     mtx.lock();
                     std::cout << Colors::Red << "ERROR: " << "Failed to extract zip entry from " << zippedMod << '\n';
                     mtx.unlock();
                     continue;
                 }
 
-                StreamDBModFile streamDBModFile(mod, fs::path(modFileName).filename().string());
-                streamDBModFile.FileData = std::vector<std::byte>(unzippedEntry, unzippedEntry + unzippedEntrySize);
-                free(unzippedEntry);
-
-                streamDBModFiles[streamDBContainerIndex].push_back(streamDBModFile);
-                zippedModCount++;
+                zippedModFiles.StreamDBModFiles[streamDBContainer].push_back(std::move(streamDBModFile));
+                zippedModFiles.Count++;
             }
         }
         else if (isSoundMod) {
             // Get the sound container info object, create it if it doesn't exist
-            mtx.lock();
-
-            ssize_t soundContainerIndex = GetSoundContainer(resourceName, soundContainerList);
-
-            if (soundContainerIndex == -1) {
-                SoundContainer soundContainer(resourceName, resourcePath);
-                soundContainerList.push_back(soundContainer);
-
-                soundContainerIndex = soundContainerList.size() - 1;
-            }
-
-            mtx.unlock();
+            SoundContainer *soundContainer = &soundContainers.GetOrAdd(resourceName, resourcePath);
 
             // Create the mod object and read the unzipped files
             if (!ProgramOptions::ListResources) {
@@ -221,56 +281,31 @@ void LoadZippedMod(std::string zippedMod,
                 }
 
                 // Load the sound mod
-                std::byte *unzippedEntry;
-                size_t unzippedEntrySize;
+                SoundModFile soundModFile(mod, fs::path(modFileName).filename().string());
 
-                if ((unzippedEntry = reinterpret_cast<std::byte*>(mz_zip_reader_extract_to_heap(&modZip, i, &unzippedEntrySize, 0))) == nullptr) {
+                if (!GetZipEntryBytes(modZip, i, modArchive, soundModFile.FileBytes)) {
                     mtx.lock();
                     std::cout << Colors::Red << "ERROR: " << "Failed to extract zip entry from " << zippedMod << '\n';
                     mtx.unlock();
                     continue;
                 }
 
-                SoundModFile soundModFile(mod, fs::path(modFileName).filename().string());
-                soundModFile.FileBytes = std::vector<std::byte>(unzippedEntry, unzippedEntry + unzippedEntrySize);
-                free(unzippedEntry);
-
-                soundModFiles[soundContainerIndex].push_back(soundModFile);
-                zippedModCount++;
+                zippedModFiles.SoundModFiles[soundContainer].push_back(std::move(soundModFile));
+                zippedModFiles.Count++;
             }
         }
         else {
-            mtx.lock();
-
-            // Get the resource object
-            ssize_t resourceContainerIndex = GetResourceContainer(resourceName, resourceContainerList);
-
-            if (resourceContainerIndex == -1) {
-                ResourceContainer resource(resourceName, PathToResourceContainer(resourceName + ".resources"));
-                resourceContainerList.push_back(resource);
-
-                resourceContainerIndex = resourceContainerList.size() - 1;
-            }
-
-            mtx.unlock();
+            // Get the resource object, create it if it doesn't exist
+            ResourceContainer *resourceContainer = &resourceContainers.GetOrAdd(resourceName, resourcePath);
 
             // Create the mod object and read the unzipped files
             ResourceModFile resourceModFile(mod, modFileName, resourceName);
 
-            if (!ProgramOptions::ListResources) {
-                // Read the mod file to memory
-                std::byte *unzippedEntry;
-                size_t unzippedEntrySize;
-
-                if ((unzippedEntry = reinterpret_cast<std::byte*>(mz_zip_reader_extract_to_heap(&modZip, i, &unzippedEntrySize, 0))) == nullptr) {
-                    mtx.lock();
-                    std::cout << Colors::Red << "ERROR: " << "Failed to extract zip entry from " << zippedMod << '\n';
-                    mtx.unlock();
-                    continue;
-                }
-
-                resourceModFile.FileBytes = std::vector<std::byte>(unzippedEntry, unzippedEntry + unzippedEntrySize);
-                free(unzippedEntry);
+            if (!ProgramOptions::ListResources && !GetZipEntryBytes(modZip, i, modArchive, resourceModFile.FileBytes)) {
+                mtx.lock();
+                std::cout << Colors::Red << "ERROR: " << "Failed to extract zip entry from " << zippedMod << '\n';
+                mtx.unlock();
+                continue;
             }
 
             // Read the JSON files in 'assetsinfo' under 'EternalMod'
@@ -279,26 +314,30 @@ void LoadZippedMod(std::string zippedMod,
                 && ToLower(modFilePathParts[2]) == "assetsinfo"
                 && fs::path(modFilePathParts[3]).extension().string() == ".json") {
                     try {
+                        // The JSON is only held in memory while it's parsed
+                        MemoryReservation memoryReservation(ModDataBudget.get(), resourceModFile.FileBytes.size());
+
                         // Read this JSON only if we are listing resources
                         if (ProgramOptions::ListResources) {
-                            std::byte *unzippedEntry;
-                            size_t unzippedEntrySize;
+                            std::vector<std::byte> unzippedEntry;
 
-                            if ((unzippedEntry = reinterpret_cast<std::byte*>(mz_zip_reader_extract_to_heap(&modZip, i, &unzippedEntrySize, 0))) == nullptr) {
+                            if (!ExtractZipEntry(modZip, i, unzippedEntry)) {
                                 mtx.lock();
                                 std::cout << Colors::Red << "ERROR: " << "Failed to extract zip entry from " << zippedMod << '\n';
                                 mtx.unlock();
                                 continue;
                             }
 
-                            resourceModFile.FileBytes = std::vector<std::byte>(unzippedEntry, unzippedEntry + unzippedEntrySize);
-                            free(unzippedEntry);
+                            resourceModFile.FileBytes = std::move(unzippedEntry);
+                        }
+                        else if (!resourceModFile.FileBytes.Load()) {
+                            throw std::exception();
                         }
 
-                        std::string assetsInfoJson(reinterpret_cast<char*>(resourceModFile.FileBytes.data()), resourceModFile.FileBytes.size());
+                        std::string assetsInfoJson(reinterpret_cast<const char*>(resourceModFile.FileBytes.data()), resourceModFile.FileBytes.size());
                         resourceModFile.AssetsInfo = AssetsInfo(assetsInfoJson);
                         resourceModFile.IsAssetsInfoJson = true;
-                        resourceModFile.FileBytes.resize(0);
+                        resourceModFile.FileBytes.clear();
                     }
                     catch (...) {
                         mtx.lock();
@@ -319,287 +358,603 @@ void LoadZippedMod(std::string zippedMod,
                 }
             }
 
-            resourceModFiles[resourceContainerIndex].push_back(resourceModFile);
-            zippedModCount++;
+            zippedModFiles.ResourceModFiles[resourceContainer].push_back(std::move(resourceModFile));
+            zippedModFiles.Count++;
         }
     }
+}
+
+// Move staged mod files to the end of their containers' mod lists
+static void AddModFilesToContainers(StagedModFiles& modFiles)
+{
+    for (auto& resourceMod : modFiles.ResourceModFiles) {
+        auto& resourceContainer = *resourceMod.first;
+        resourceContainer.ModFileList.insert(resourceContainer.ModFileList.end(), std::make_move_iterator(resourceMod.second.begin()), std::make_move_iterator(resourceMod.second.end()));
+    }
+
+    for (auto& soundMod : modFiles.SoundModFiles) {
+        auto& soundContainer = *soundMod.first;
+        soundContainer.ModFileList.insert(soundContainer.ModFileList.end(), std::make_move_iterator(soundMod.second.begin()), std::make_move_iterator(soundMod.second.end()));
+    }
+
+    for (auto& streamDBMod : modFiles.StreamDBModFiles) {
+        auto& streamDBContainer = *streamDBMod.first;
+        streamDBContainer.ModFiles.insert(streamDBContainer.ModFiles.end(), std::make_move_iterator(streamDBMod.second.begin()), std::make_move_iterator(streamDBMod.second.end()));
+    }
+}
+
+// Check a mod's staged files for online safety and add them to their containers
+static void AddStagedModFiles(const std::string& modPath, Mod& mod, StagedModFiles& modFiles)
+{
+    size_t modFileCount = modFiles.Count;
 
     mtx.lock();
 
+    // Mods are named by their path in conflict reports
+    mod.Path = modPath;
+
     // Check if the mod is safe for online play
-    if (!IsModSafeForOnline(resourceModFiles)) {
+    if (!IsModSafeForOnline(modFiles.ResourceModFiles)) {
         ProgramOptions::AreModsSafeForOnline = false;
         mod.IsSafeForOnline = false;
-
-        // Unload the mod files if necessary
-        if (!ProgramOptions::LoadOnlineSafeModsOnly) {
-            for (const auto& resourceMod : resourceModFiles) {
-                auto& resourceContainer = resourceContainerList[resourceMod.first];
-                resourceContainer.ModFileList.insert(resourceContainer.ModFileList.end(), resourceMod.second.begin(), resourceMod.second.end());
-            }
-
-            for (const auto& soundMod : soundModFiles) {
-                auto& soundContainer = soundContainerList[soundMod.first];
-                soundContainer.ModFileList.insert(soundContainer.ModFileList.end(), soundMod.second.begin(), soundMod.second.end());
-            }
-
-            for (const auto& streamDBMod : streamDBModFiles) {
-                auto& streamDBContainer = streamDBContainerList[streamDBMod.first];
-                streamDBContainer.ModFiles.insert(streamDBContainer.ModFiles.end(), streamDBMod.second.begin(), streamDBMod.second.end());
-            }
-        }
     }
-    else {
-        for (const auto& resourceMod : resourceModFiles) {
-            auto& resourceContainer = resourceContainerList[resourceMod.first];
-            resourceContainer.ModFileList.insert(resourceContainer.ModFileList.end(), resourceMod.second.begin(), resourceMod.second.end());
-        }
-
-        for (const auto& soundMod : soundModFiles) {
-            auto& soundContainer = soundContainerList[soundMod.first];
-            soundContainer.ModFileList.insert(soundContainer.ModFileList.end(), soundMod.second.begin(), soundMod.second.end());
-        }
 
-        for (const auto& streamDBMod : streamDBModFiles) {
-            auto& streamDBContainer = streamDBContainerList[streamDBMod.first];
-            streamDBContainer.ModFiles.insert(streamDBContainer.ModFiles.end(), streamDBMod.second.begin(), streamDBMod.second.end());
-        }
+    // Leave unsafe mods out if only online-safe mods are loaded
+    if (mod.IsSafeForOnline || !ProgramOptions::LoadOnlineSafeModsOnly) {
+        AddModFilesToContainers(modFiles);
     }
 
     mtx.unlock();
 
-    if (zippedModCount > 0 && !ProgramOptions::ListResources) {
+    if (modFileCount > 0 && !ProgramOptions::ListResources) {
         mtx.lock();
 
         if (!ProgramOptions::LoadOnlineSafeModsOnly || (ProgramOptions::LoadOnlineSafeModsOnly && mod.IsSafeForOnline)) {
-            std::cout << "Found " << Colors::Blue << zippedModCount << " file(s) " << Colors::Reset << "in archive " << Colors::Yellow << zippedMod << Colors::Reset << "..." << '\n';
+            std::cout << "Found " << Colors::Blue << modFileCount << " file(s) " << Colors::Reset << "in archive " << Colors::Yellow << modPath << Colors::Reset << "..." << '\n';
 
             if (!mod.IsSafeForOnline) {
-                std::cout << Colors::Yellow << "WARNING: Mod " << zippedMod
+                std::cout << Colors::Yellow << "WARNING: Mod " << modPath
                     << " is not safe for online play, public matchmaking will be disabled" << Colors::Reset << '\n';
             }
         }
         else {
-            std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Mod " << Colors::Yellow << zippedMod << Colors::Reset << " is not safe for public matchmaking, skipping" << '\n';
+            std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Mod " << Colors::Yellow << modPath << Colors::Reset << " is not safe for public matchmaking, skipping" << '\n';
         }
 
         mtx.unlock();
     }
-
-    mz_zip_reader_end(&modZip);
 }
 
-void LoadUnzippedMod(std::string unzippedMod, Mod& globalLooseMod, std::atomic<size_t>& unzippedModCount,
-    std::map<size_t, std::vector<ResourceModFile>>& resourceModFiles,
-    std::map<size_t, std::vector<SoundModFile>>& soundModFiles,
-    std::map<size_t, std::vector<StreamDBModFile>>& streamDBModFiles,
-    std::vector<ResourceContainer>& resourceContainerList, std::vector<SoundContainer>& soundContainerList,
-    std::vector<StreamDBContainer>& streamDBContainerList, std::vector<std::string>& notFoundContainers)
+void LoadZippedMod(std::string zippedMod, ThreadPool *threadPool,
+    ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers)
 {
-    std::replace(unzippedMod.begin(), unzippedMod.end(), SEPARATOR, '/');
-    std::vector<std::string> modFilePathParts = SplitString(unzippedMod, '/');
+    // Map the zipped mod, so stored entries can be used without copying them
+    std::shared_ptr<MemoryMappedFile> modArchive;
 
-    if (modFilePathParts.size() < 4) {
+    try {
+        modArchive = std::make_shared<MemoryMappedFile>(zippedMod, true);
+    }
+    catch (...) {
+        mtx.lock();
+        std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << zippedMod << " for reading." << '\n';
+        mtx.unlock();
         return;
     }
 
-    // Determine the game container for each mod file
-    bool isSoundMod = false;
-    bool isStreamDBMod = false;
-    std::string resourceName = modFilePathParts[2];
-    std::string fileName;
+    // Load zipped mod
+    mz_zip_archive modZip;
+    mz_zip_zero_struct(&modZip);
+    mz_zip_reader_init_mem(&modZip, modArchive->Mem, modArchive->Size, 0);
 
-    // Old mods compatibility
-    if (ToLower(resourceName) == "generated") {
-        resourceName = "gameresources";
-        fileName = unzippedMod.substr(modFilePathParts[1].size() + 3, unzippedMod.size() - modFilePathParts[1].size() - 3);
-    }
-    else {
-        // Remove the resource name from the path
-        fileName = unzippedMod.substr(modFilePathParts[1].size() + resourceName.size() + 4, unzippedMod.size() - resourceName.size() - 4);
-    }
+    // Shared by all of the mod's files
+    auto mod = std::make_shared<Mod>();
 
-    // Redirect .blang files to a different container if specified
-    if (!ProgramOptions::BlangFileContainerRedirect.empty() && modFilePathParts[3] == "EternalMod" && modFilePathParts[4] == "strings") {
-        resourceName = ProgramOptions::BlangFileContainerRedirect;
-    }
+    if (!ProgramOptions::ListResources) {
+        // Read the mod info from the EternalMod JSON if it exists
+        char *unzippedModJson;
+        size_t unzippedModJsonSize;
 
-    // Get path to resource file
-    std::string resourcePath = PathToResourceContainer(resourceName + ".resources");
+        if ((unzippedModJson = static_cast<char*>(mz_zip_reader_extract_file_to_heap(&modZip, "EternalMod.json", &unzippedModJsonSize, 0))) != nullptr) {
+            std::string modJson(unzippedModJson, unzippedModJsonSize);
+            free(unzippedModJson);
 
-    // Check if this is a streamdb mod
-    if (resourceName == "streamdb") {
-        isStreamDBMod = true;
-        resourcePath = ProgramOptions::BasePath + "EternalMod.streamdb";
+            try {
+                // Try to parse the JSON
+                *mod = Mod(modJson);
+
+                // If the mod requires a higher mod loader version, print a warning and don't load the mod
+                if (mod->RequiredVersion > VERSION) {
+                    mtx.lock();
+                    std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Mod " << fs::path(zippedMod).filename().string() << " requires mod loader version "
+                        << mod->RequiredVersion << " but the current mod loader version is " << VERSION << ", skipping" << '\n';
+                    mtx.unlock();
+                    return;
+                }
+            }
+            catch (...) {
+                mtx.lock();
+                std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod.json - using defaults." << '\n';
+                mtx.unlock();
+            }
+        }
     }
 
-    // Check if this is a sound mod
-    if (resourcePath.empty() && !isStreamDBMod) {
-        resourcePath = PathToSoundContainer(resourceName);
+    // Split big archives into ranges of entries, loaded in parallel with their own zip readers
+    unsigned int zipEntryCount = modZip.m_total_files;
+    size_t rangeCount = 1;
 
-        if (!resourcePath.empty()) {
-            isSoundMod = true;
-        }
-        else {
-            mtx.lock();
+    if (threadPool != nullptr) {
+        rangeCount = std::clamp<size_t>(zipEntryCount / MinZipEntriesPerTask, 1, threadPool->ThreadCount());
+    }
 
-            if (std::find(notFoundContainers.begin(), notFoundContainers.end(), resourceName) == notFoundContainers.end()) {
-                notFoundContainers.push_back(resourceName);
-            }
+    std::vector<StagedModFiles> zippedModFileRanges(rangeCount);
 
-            mtx.unlock();
-            return;
-        }
+    if (rangeCount == 1) {
+        LoadZippedModEntries(zippedMod, mod, modZip, modArchive, 0, zipEntryCount, zippedModFileRanges[0],
+            resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
     }
+    else {
+        TaskGroup rangeTasks;
 
-    if (isStreamDBMod) {
-        // Get the streamdb container info object, create it if it doesn't exist
-        mtx.lock();
+        for (size_t range = 0; range < rangeCount; range++) {
+            unsigned int firstEntry = zipEntryCount * range / rangeCount;
+            unsigned int lastEntry = zipEntryCount * (range + 1) / rangeCount;
 
-        auto x = std::find_if(streamDBContainerList.begin(), streamDBContainerList.end(),
-            [](const StreamDBContainer& streamDbContainer) { return streamDbContainer.Name == "EternalMod.streamdb"; });
+            threadPool->Submit([&, range, firstEntry, lastEntry] {
+                mz_zip_archive rangeZip;
+                mz_zip_zero_struct(&rangeZip);
+                mz_zip_reader_init_mem(&rangeZip, modArchive->Mem, modArchive->Size, MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY);
 
-        if (x == streamDBContainerList.end()) {
-            streamDBContainerList.push_back(StreamDBContainer("EternalMod.streamdb", resourcePath));
-            x = streamDBContainerList.end() - 1;
+                LoadZippedModEntries(zippedMod, mod, rangeZip, modArchive, firstEntry, lastEntry, zippedModFileRanges[range],
+                    resourceContainers, soundContainers, streamDBContainers, notFoundContainers);
+
+                mz_zip_reader_end(&rangeZip);
+            }, &rangeTasks);
         }
 
-        auto streamDBContainerIndex = std::distance(streamDBContainerList.begin(), x);
+        threadPool->Wait(rangeTasks);
+    }
 
-        mtx.unlock();
+    // Merge the ranges in entry order, so the result doesn't depend on scheduling
+    StagedModFiles zippedModFiles;
 
-        if (!ProgramOptions::ListResources) {
-            // Load the streamdb mod
-            size_t unzippedModSize = fs::file_size(unzippedMod);
+    for (auto& zippedModFileRange : zippedModFileRanges) {
+        zippedModFiles.Merge(zippedModFileRange);
+    }
 
-            StreamDBModFile streamDBModFile(globalLooseMod, fs::path(fileName).filename().string());
+    AddStagedModFiles(zippedMod, *mod, zippedModFiles);
 
-            FILE *unzippedModFile = fopen(unzippedMod.c_str(), "rb");
+    mz_zip_reader_end(&modZip);
+}
 
-            if (!unzippedModFile) {
-                mtx.lock();
-                std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << unzippedMod << " for reading." << '\n';
-                mtx.unlock();
-                return;
-            }
+void LoadPackagedMod(std::string packagedMod, ContainerRegistry<ResourceContainer>& resourceContainers,
+    ContainerRegistry<SoundContainer>& soundContainers, ContainerRegistry<StreamDBContainer>& streamDBContainers,
+    std::vector<std::string>& notFoundContainers)
+{
+    // Map the package, its routing table is read straight from it
+    std::unique_ptr<ModPackage> modPackage;
 
-            streamDBModFile.FileData.resize(unzippedModSize);
+    try {
+        modPackage = std::make_unique<ModPackage>(packagedMod);
+    }
+    catch (...) {
+        mtx.lock();
+        std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to read package " << packagedMod << ", try packing it again with --pack" << '\n';
+        mtx.unlock();
+        return;
+    }
 
-            if (fread(streamDBModFile.FileData.data(), 1, unzippedModSize, unzippedModFile) != unzippedModSize) {
-                mtx.lock();
-                std::cout << Colors::Reset << "ERROR: " << Colors::Reset << "Failed to read from " << unzippedMod << "." << '\n';
-                mtx.unlock();
-                return;
-            }
+    // Shared by all of the mod's files
+    auto mod = std::make_shared<Mod>();
 
-            fclose(unzippedModFile);
+    if (!ProgramOptions::ListResources) {
+        // The mod info was parsed when the mod was packaged
+        mod->LoadPriority = modPackage->LoadPriority;
+        mod->RequiredVersion = modPackage->RequiredVersion;
 
+        // If the mod requires a higher mod loader version, print a warning and don't load the mod
+        if (mod->RequiredVersion > VERSION) {
             mtx.lock();
-            streamDBModFiles[streamDBContainerIndex].push_back(streamDBModFile);
+            std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Mod " << fs::path(packagedMod).filename().string() << " requires mod loader version "
+                << mod->RequiredVersion << " but the current mod loader version is " << VERSION << ", skipping" << '\n';
             mtx.unlock();
-
-            unzippedModCount++;
+            return;
         }
     }
-    else if (isSoundMod) {
-        mtx.lock();
 
-        // Get the sound container info object, create it if it doesn't exist
-        ssize_t soundContainerIndex = GetSoundContainer(resourceName, soundContainerList);
+    StagedModFiles packagedModFiles;
 
-        if (soundContainerIndex == -1) {
-            SoundContainer soundContainer(resourceName, resourcePath);
-            soundContainerList.push_back(soundContainer);
+    for (const auto& entry : modPackage->Entries) {
+        std::string resourceName = entry.ResourceName;
 
-            soundContainerIndex = soundContainerList.size() - 1;
+        // Redirect .blang files to a different container if specified
+        if (!ProgramOptions::BlangFileContainerRedirect.empty() && (entry.Flags & RedirectableEntry) != 0) {
+            resourceName = ProgramOptions::BlangFileContainerRedirect;
         }
 
-        mtx.unlock();
+        // Get path to resource file
+        bool isSoundMod = false;
+        bool isStreamDBMod = false;
+        std::string resourcePath = PathToResourceContainer(resourceName + ".resources");
 
-        // Create the mod object and read the unzipped files
-        if (!ProgramOptions::ListResources) {
-            // Skip unsupported formats
-            std::string soundExtension = fs::path(fileName).extension().string();
+        // Check if this is a streamdb mod
+        if (resourceName == "streamdb") {
+            isStreamDBMod = true;
+            resourcePath = ProgramOptions::BasePath + "EternalMod.streamdb";
+        }
 
-            if (std::find(SupportedSoundFormats.begin(), SupportedSoundFormats.end(), soundExtension) == SupportedSoundFormats.end()) {
+        // Check if this is a sound mod
+        if (resourcePath.empty() && !isStreamDBMod) {
+            resourcePath = PathToSoundContainer(resourceName);
+
+            if (!resourcePath.empty()) {
+                isSoundMod = true;
+            }
+            else {
                 mtx.lock();
-                std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Unsupported sound mod file format " << soundExtension << " for file " << fileName << '\n';
+
+                if (std::find(notFoundContainers.begin(), notFoundContainers.end(), resourceName) == notFoundContainers.end()) {
+                    notFoundContainers.push_back(resourceName);
+                }
+
                 mtx.unlock();
-                return;
+                continue;
             }
+        }
 
-            // Load the sound mod
-            size_t unzippedModSize = fs::file_size(unzippedMod);
+        if (isStreamDBMod) {
+            // Get the streamdb container info object, create it if it doesn't exist
+            StreamDBContainer *streamDBContainer = &streamDBContainers.GetOrAdd("EternalMod.streamdb", resourcePath);
 
-            SoundModFile soundModFile(globalLooseMod, fs::path(fileName).filename().string());
+            if (!ProgramOptions::ListResources) {
+                StreamDBModFile streamDBModFile(mod, fs::path(entry.Name).filename().string());
+                streamDBModFile.FileData = ModFileBytes(modPackage->Package, entry.DataOffset, entry.DataSize);
+                packagedModFiles.StreamDBModFiles[streamDBContainer].push_back(std::move(streamDBModFile));
+                packagedModFiles.Count++;
+            }
+        }
+        else if (isSoundMod) {
+            // Get the sound container info object, create it if it doesn't exist
+            SoundContainer *soundContainer = &soundContainers.GetOrAdd(resourceName, resourcePath);
 
-            FILE *unzippedModFile = fopen(unzippedMod.c_str(), "rb");
+            if (!ProgramOptions::ListResources) {
+                // Skip unsupported formats
+                std::string soundExtension = fs::path(entry.Name).extension().string();
 
-            if (!unzippedModFile) {
+                if (std::find(SupportedSoundFormats.begin(), SupportedSoundFormats.end(), soundExtension) == SupportedSoundFormats.end()) {
+                    mtx.lock();
+                    std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Unsupported sound mod file format " << soundExtension << " for file " << entry.Name << '\n';
+                    mtx.unlock();
+                    continue;
+                }
+
+                SoundModFile soundModFile(mod, fs::path(entry.Name).filename().string());
+                soundModFile.FileBytes = ModFileBytes(modPackage->Package, entry.DataOffset, entry.DataSize);
+                packagedModFiles.SoundModFiles[soundContainer].push_back(std::move(soundModFile));
+                packagedModFiles.Count++;
+            }
+        }
+        else {
+            // Get the resource object, create it if it doesn't exist
+            ResourceContainer *resourceContainer = &resourceContainers.GetOrAdd(resourceName, resourcePath);
+
+            if ((entry.Flags & SkippedResourceEntry) != 0) {
+                continue;
+            }
+
+            ResourceModFile resourceModFile(mod, entry.Name, resourceName);
+            resourceModFile.IsBlangJson = (entry.Flags & BlangJsonEntry) != 0;
+
+            try {
+                if ((entry.Flags & AssetsInfoEntry) != 0) {
+                    resourceModFile.AssetsInfo = modPackage->ReadAssetsInfo(entry);
+                    resourceModFile.IsAssetsInfoJson = true;
+                }
+                else if ((entry.Flags & ParsedBlangEntry) != 0) {
+                    if (!ProgramOptions::ListResources) {
+                        resourceModFile.BlangStrings = modPackage->ReadBlangStrings(entry);
+                    }
+                }
+                else if (!ProgramOptions::ListResources) {
+                    // Use the data straight from the mapped package, with the precompressed texture if needed
+                    if (ProgramOptions::CompressTextures && entry.TextureSize != 0) {
+                        resourceModFile.FileBytes = ModFileBytes(modPackage->Package, entry.TextureOffset, entry.TextureSize);
+                    }
+                    else {
+                        resourceModFile.FileBytes = ModFileBytes(modPackage->Package, entry.DataOffset, entry.DataSize);
+                    }
+                }
+            }
+            catch (...) {
                 mtx.lock();
-                std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << unzippedMod << " for reading." << '\n';
+                std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to read " << entry.Name << " from package " << packagedMod << '\n';
                 mtx.unlock();
-                return;
+                continue;
             }
 
-            soundModFile.FileBytes.resize(unzippedModSize);
+            packagedModFiles.ResourceModFiles[resourceContainer].push_back(std::move(resourceModFile));
+            packagedModFiles.Count++;
+        }
+    }
+
+    AddStagedModFiles(packagedMod, *mod, packagedModFiles);
+}
+
+void ListZippedMod(std::string zippedMod, ListResourcesCache& listResourcesCache, ListedResources& listedResources,
+    ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers)
+{
+    // Get the mod's files from the cache, or from its central directory if it changed
+    std::optional<ArchiveSummary> summary = listResourcesCache.GetSummary(zippedMod);
 
-            if (fread(soundModFile.FileBytes.data(), 1, unzippedModSize, unzippedModFile) != unzippedModSize) {
+    if (!summary.has_value()) {
+        mtx.lock();
+        std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << zippedMod << " for reading." << '\n';
+        mtx.unlock();
+        return;
+    }
+
+    std::vector<std::pair<std::string, const ArchiveContainer*>> listedContainers;
+    bool isSafeForOnline = true;
+
+    for (const auto& archiveContainer : summary->Containers) {
+        std::string resourceName = archiveContainer.ResourceName;
+
+        // Redirect .blang files to a different container if specified
+        if (!ProgramOptions::BlangFileContainerRedirect.empty() && (archiveContainer.Flags & RedirectableArchiveContainer) != 0) {
+            resourceName = ProgramOptions::BlangFileContainerRedirect;
+        }
+
+        // Get path to resource file
+        std::string resourcePath = PathToResourceContainer(resourceName + ".resources");
+
+        // Check if this is a streamdb mod
+        if (resourceName == "streamdb") {
+            streamDBContainers.GetOrAdd("EternalMod.streamdb", ProgramOptions::BasePath + "EternalMod.streamdb");
+            continue;
+        }
+
+        // Check if this is a sound mod
+        if (resourcePath.empty()) {
+            resourcePath = PathToSoundContainer(resourceName);
+
+            if (!resourcePath.empty()) {
+                soundContainers.GetOrAdd(resourceName, resourcePath);
+            }
+            else {
                 mtx.lock();
-                std::cout << Colors::Reset << "ERROR: " << Colors::Reset << "Failed to read from " << unzippedMod << "." << '\n';
+
+                if (std::find(notFoundContainers.begin(), notFoundContainers.end(), resourceName) == notFoundContainers.end()) {
+                    notFoundContainers.push_back(resourceName);
+                }
+
                 mtx.unlock();
-                return;
             }
 
-            fclose(unzippedModFile);
+            continue;
+        }
+
+        // Create the resource object if it doesn't exist, so containers are listed in the order mods first use them
+        resourceContainers.GetOrAdd(resourceName, resourcePath);
 
-            mtx.lock();
-            soundModFiles[soundContainerIndex].push_back(soundModFile);
-            mtx.unlock();
+        if (archiveContainer.ModFileName.empty() && (archiveContainer.Flags & AssetsInfoArchiveContainer) == 0) {
+            continue;
+        }
+
+        // Mods can't modify non-whitelisted files in unsafe resources, or add assets to them
+        if (IsUnsafeResourceName(resourceName)
+        && (!archiveContainer.UnsafeModFileName.empty() || (archiveContainer.Flags & AssetsInfoArchiveContainer) != 0)) {
+            isSafeForOnline = false;
+        }
+
+        listedContainers.emplace_back(resourceName, &archiveContainer);
+    }
+
+    mtx.lock();
+
+    if (!isSafeForOnline) {
+        ProgramOptions::AreModsSafeForOnline = false;
+    }
+
+    // Leave unsafe mods out if only online-safe mods are loaded
+    if (isSafeForOnline || !ProgramOptions::LoadOnlineSafeModsOnly) {
+        for (const auto& [resourceName, archiveContainer] : listedContainers) {
+            ListedResourceContainer& listedContainer = listedResources.ResourceContainers[resourceName];
+
+            if (!archiveContainer->ModFileName.empty()) {
+                listedContainer.HasModFiles = true;
+
+                if (!IsMultiplayerDisablerFile(archiveContainer->ModFileName)) {
+                    listedContainer.HasOnlyDisablerFiles = false;
+                }
+            }
+
+            listedContainer.ModifiesMaps |= (archiveContainer->Flags & ModifiesMapsArchiveContainer) != 0;
+            listedResources.ModifiesPackageMapSpec |= (archiveContainer->Flags & ModifiesResourcesArchiveContainer) != 0;
+        }
+    }
+
+    mtx.unlock();
+}
+
+std::optional<std::set<std::string>> GetModContainerNames(const std::string& mod)
+{
+    std::set<std::string> containerNames;
+
+    // Packages already store the container of each entry
+    if (fs::path(mod).extension() == ".emlpack") {
+        try {
+            ModPackage modPackage(mod);
+
+            for (const auto& entry : modPackage.Entries) {
+                if (!ProgramOptions::BlangFileContainerRedirect.empty() && (entry.Flags & RedirectableEntry) != 0) {
+                    containerNames.insert(ProgramOptions::BlangFileContainerRedirect);
+                }
+                else {
+                    containerNames.insert(entry.ResourceName);
+                }
+            }
+        }
+        catch (...) {
+            return std::nullopt;
+        }
+
+        return containerNames;
+    }
+
+    // Only the zip's central directory is read
+    std::unique_ptr<MemoryMappedFile> modArchive;
 
-            unzippedModCount++;
+    try {
+        modArchive = std::make_unique<MemoryMappedFile>(mod, true);
+    }
+    catch (...) {
+        return std::nullopt;
+    }
+
+    mz_zip_archive modZip;
+    mz_zip_zero_struct(&modZip);
+
+    if (!mz_zip_reader_init_mem(&modZip, modArchive->Mem, modArchive->Size, MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY)) {
+        return std::nullopt;
+    }
+
+    for (unsigned int i = 0; i < modZip.m_total_files; i++) {
+        unsigned int zipEntryNameSize = mz_zip_reader_get_filename(&modZip, i, nullptr, 0);
+        auto zipEntryNameBuffer = std::make_unique<char[]>(zipEntryNameSize);
+
+        if (mz_zip_reader_get_filename(&modZip, i, zipEntryNameBuffer.get(), zipEntryNameSize) != zipEntryNameSize) {
+            continue;
+        }
+
+        std::vector<std::string> modFilePathParts = SplitString(std::string(zipEntryNameBuffer.get()), '/');
+
+        if (modFilePathParts.size() < 2) {
+            continue;
         }
+
+        containerNames.insert(GetModFileContainerName(modFilePathParts, 0));
+    }
+
+    mz_zip_reader_end(&modZip);
+    return containerNames;
+}
+
+std::set<std::string> GetUnzippedModContainerNames(const std::vector<std::string>& unzippedMods)
+{
+    std::set<std::string> containerNames;
+
+    for (auto unzippedMod : unzippedMods) {
+        std::replace(unzippedMod.begin(), unzippedMod.end(), SEPARATOR, '/');
+        std::vector<std::string> modFilePathParts = SplitString(unzippedMod, '/');
+
+        if (modFilePathParts.size() < 4) {
+            continue;
+        }
+
+        containerNames.insert(GetModFileContainerName(modFilePathParts, 2));
+    }
+
+    return containerNames;
+}
+
+void LoadUnzippedMod(std::string unzippedMod, const std::shared_ptr<const Mod>& globalLooseMod, StagedModFiles& stagedModFiles,
+    ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers)
+{
+    std::replace(unzippedMod.begin(), unzippedMod.end(), SEPARATOR, '/');
+    std::vector<std::string> modFilePathParts = SplitString(unzippedMod, '/');
+
+    if (modFilePathParts.size() < 4) {
+        return;
+    }
+
+    // Determine the game container for each mod file
+    bool isSoundMod = false;
+    bool isStreamDBMod = false;
+    std::string resourceName = GetModFileContainerName(modFilePathParts, 2);
+    std::string fileName;
+
+    // Old mods compatibility
+    if (ToLower(modFilePathParts[2]) == "generated") {
+        fileName = unzippedMod.substr(modFilePathParts[1].size() + 3, unzippedMod.size() - modFilePathParts[1].size() - 3);
     }
     else {
-        mtx.lock();
+        // Remove the resource name from the path
+        fileName = unzippedMod.substr(modFilePathParts[1].size() + modFilePathParts[2].size() + 4, unzippedMod.size() - modFilePathParts[2].size() - 4);
+    }
 
-        // Get the resource object
-        ssize_t resourceContainerIndex = GetResourceContainer(resourceName, resourceContainerList);
+    // Get path to resource file
+    std::string resourcePath = PathToResourceContainer(resourceName + ".resources");
 
-        if (resourceContainerIndex == -1) {
-            ResourceContainer resourceContainer(resourceName, PathToResourceContainer(resourceName + ".resources"));
-            resourceContainerList.push_back(resourceContainer);
+    // Check if this is a streamdb mod
+    if (resourceName == "streamdb") {
+        isStreamDBMod = true;
+        resourcePath = ProgramOptions::BasePath + "EternalMod.streamdb";
+    }
 
-            resourceContainerIndex = resourceContainerList.size() - 1;
+    // Check if this is a sound mod
+    if (resourcePath.empty() && !isStreamDBMod) {
+        resourcePath = PathToSoundContainer(resourceName);
+
+        if (!resourcePath.empty()) {
+            isSoundMod = true;
         }
+        else {
+            if (std::find(stagedModFiles.NotFoundContainers.begin(), stagedModFiles.NotFoundContainers.end(), resourceName) == stagedModFiles.NotFoundContainers.end()) {
+                stagedModFiles.NotFoundContainers.push_back(resourceName);
+            }
 
-        mtx.unlock();
+            return;
+        }
+    }
 
-        // Create the mod object and read the files
-        ResourceModFile resourceModFile(globalLooseMod, fileName, resourceName);
+    if (isStreamDBMod) {
+        // Get the streamdb container info object, create it if it doesn't exist
+        StreamDBContainer *streamDBContainer = &streamDBContainers.GetOrAdd("EternalMod.streamdb", resourcePath);
 
         if (!ProgramOptions::ListResources) {
-            size_t unzippedModSize = fs::file_size(unzippedMod);
+            // Load the streamdb mod, the file is only read when it's written
+            StreamDBModFile streamDBModFile(globalLooseMod, fs::path(fileName).filename().string());
+            streamDBModFile.FileData = ModFileBytes(unzippedMod, fs::file_size(unzippedMod));
+            stagedModFiles.StreamDBModFiles[streamDBContainer].push_back(std::move(streamDBModFile));
+            stagedModFiles.Count++;
+        }
+    }
+    else if (isSoundMod) {
+        // Get the sound container info object, create it if it doesn't exist
+        SoundContainer *soundContainer = &soundContainers.GetOrAdd(resourceName, resourcePath);
 
-            FILE *unzippedModFile = fopen(unzippedMod.c_str(), "rb");
+        // Create the mod object and read the unzipped files
+        if (!ProgramOptions::ListResources) {
+            // Skip unsupported formats
+            std::string soundExtension = fs::path(fileName).extension().string();
 
-            if (!unzippedModFile) {
+            if (std::find(SupportedSoundFormats.begin(), SupportedSoundFormats.end(), soundExtension) == SupportedSoundFormats.end()) {
                 mtx.lock();
-                std::cout << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << unzippedMod << " for reading." << '\n';
+                std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Unsupported sound mod file format " << soundExtension << " for file " << fileName << '\n';
                 mtx.unlock();
                 return;
             }
 
-            resourceModFile.FileBytes.resize(unzippedModSize);
+            // Load the sound mod, the file is only read when it's injected
+            SoundModFile soundModFile(globalLooseMod, fs::path(fileName).filename().string());
+            soundModFile.FileBytes = ModFileBytes(unzippedMod, fs::file_size(unzippedMod));
+            stagedModFiles.SoundModFiles[soundContainer].push_back(std::move(soundModFile));
+            stagedModFiles.Count++;
+        }
+    }
+    else {
+        // Get the resource object, create it if it doesn't exist
+        ResourceContainer *resourceContainer = &resourceContainers.GetOrAdd(resourceName, resourcePath);
 
-            if (fread(resourceModFile.FileBytes.data(), 1, unzippedModSize, unzippedModFile) != unzippedModSize) {
-                mtx.lock();
-                std::cout << Colors::Reset << "ERROR: " << Colors::Reset << "Failed to read from " << unzippedMod << "." << '\n';
-                mtx.unlock();
-                return;
-            }
+        // Create the mod object and read the files
+        ResourceModFile resourceModFile(globalLooseMod, fileName, resourceName);
 
-            fclose(unzippedModFile);
+        if (!ProgramOptions::ListResources) {
+            // The file is only read when it's injected
+            resourceModFile.FileBytes = ModFileBytes(unzippedMod, fs::file_size(unzippedMod));
         }
 
         // Read the JSON files in 'assetsinfo' under 'EternalMod'
@@ -608,6 +963,9 @@ void LoadUnzippedMod(std::string unzippedMod, Mod& globalLooseMod, std::atomic<s
             && ToLower(modFilePathParts[4]) == "assetsinfo"
             && fs::path(modFilePathParts[5]).extension().string() == ".json") {
                 try {
+                    // The JSON is only held in memory while it's parsed
+                    MemoryReservation memoryReservation(ModDataBudget.get(), resourceModFile.FileBytes.size());
+
                     // Read this JSON only if we are listing resources
                     if (ProgramOptions::ListResources) {
                         size_t unzippedModSize = fs::file_size(unzippedMod);
@@ -621,9 +979,9 @@ void LoadUnzippedMod(std::string unzippedMod, Mod& globalLooseMod, std::atomic<s
                             return;
                         }
 
-                        resourceModFile.FileBytes.resize(unzippedModSize);
+                        std::vector<std::byte> unzippedModBytes(unzippedModSize);
 
-                        if (fread(resourceModFile.FileBytes.data(), 1, unzippedModSize, unzippedModFile) != unzippedModSize) {
+                        if (fread(unzippedModBytes.data(), 1, unzippedModSize, unzippedModFile) != unzippedModSize) {
                             mtx.lock();
                             std::cout << Colors::Reset << "ERROR: " << Colors::Reset << "Failed to read from " << unzippedMod << "." << '\n';
                             mtx.unlock();
@@ -631,12 +989,16 @@ void LoadUnzippedMod(std::string unzippedMod, Mod& globalLooseMod, std::atomic<s
                         }
 
                         fclose(unzippedModFile);
+                        resourceModFile.FileBytes = std::move(unzippedModBytes);
+                    }
+                    else if (!resourceModFile.FileBytes.Load()) {
+                        throw std::exception();
                     }
 
-                    std::string assetsInfoJson(reinterpret_cast<char*>(resourceModFile.FileBytes.data()), resourceModFile.FileBytes.size());
+                    std::string assetsInfoJson(reinterpret_cast<const char*>(resourceModFile.FileBytes.data()), resourceModFile.FileBytes.size());
                     resourceModFile.AssetsInfo = AssetsInfo(assetsInfoJson);
                     resourceModFile.IsAssetsInfoJson = true;
-                    resourceModFile.FileBytes.resize(0);
+                    resourceModFile.FileBytes.clear();
                 }
                 catch (...) {
                     mtx.lock();
@@ -657,10 +1019,82 @@ void LoadUnzippedMod(std::string unzippedMod, Mod& globalLooseMod, std::atomic<s
             }
         }
 
-        mtx.lock();
-        resourceModFiles[resourceContainerIndex].push_back(resourceModFile);
-        mtx.unlock();
+        stagedModFiles.ResourceModFiles[resourceContainer].push_back(std::move(resourceModFile));
+        stagedModFiles.Count++;
+    }
+}
 
-        unzippedModCount++;
+void LoadUnzippedMods(const std::vector<std::string>& unzippedMods, ThreadPool *threadPool, const std::shared_ptr<const Mod>& globalLooseMod,
+    StagedModFiles& looseModFiles, ContainerRegistry<ResourceContainer>& resourceContainers, ContainerRegistry<SoundContainer>& soundContainers,
+    ContainerRegistry<StreamDBContainer>& streamDBContainers, std::vector<std::string>& notFoundContainers)
+{
+    // Split the files into batches, each staging its mod files separately
+    size_t batchCount = threadPool != nullptr ? (unzippedMods.size() + LooseFilesPerTask - 1) / LooseFilesPerTask : 1;
+    std::vector<StagedModFiles> batches(std::max<size_t>(batchCount, 1));
+
+    if (threadPool != nullptr) {
+        TaskGroup batchTasks;
+
+        for (size_t batch = 0; batch < batchCount; batch++) {
+            threadPool->Submit([&, batch] {
+                size_t lastFile = std::min(unzippedMods.size(), (batch + 1) * LooseFilesPerTask);
+
+                for (size_t i = batch * LooseFilesPerTask; i < lastFile; i++) {
+                    LoadUnzippedMod(unzippedMods[i], globalLooseMod, batches[batch], resourceContainers, soundContainers, streamDBContainers);
+                }
+            }, &batchTasks);
+        }
+
+        threadPool->Wait(batchTasks);
+    }
+    else {
+        for (const auto& unzippedMod : unzippedMods) {
+            LoadUnzippedMod(unzippedMod, globalLooseMod, batches[0], resourceContainers, soundContainers, streamDBContainers);
+        }
+    }
+
+    // Merge the batches in file order
+    for (auto& batch : batches) {
+        looseModFiles.Merge(batch);
+    }
+
+    for (auto& resourceName : looseModFiles.NotFoundContainers) {
+        if (std::find(notFoundContainers.begin(), notFoundContainers.end(), resourceName) == notFoundContainers.end()) {
+            notFoundContainers.push_back(resourceName);
+        }
+    }
+}
+
+void AddLooseModFiles(StagedModFiles& looseModFiles, Mod& globalLooseMod)
+{
+    mtx.lock();
+
+    globalLooseMod.Path = "'Mods' folder";
+
+    // Check if the unzipped mods are safe for online play
+    if (!IsModSafeForOnline(looseModFiles.ResourceModFiles)) {
+        // Mods are not safe for online
+        // Check if they should be loaded
+        ProgramOptions::AreModsSafeForOnline = false;
+        globalLooseMod.IsSafeForOnline = false;
+    }
+
+    if (globalLooseMod.IsSafeForOnline || !ProgramOptions::LoadOnlineSafeModsOnly) {
+        AddModFilesToContainers(looseModFiles);
     }
+
+    if (looseModFiles.Count > 0 && !ProgramOptions::ListResources) {
+        if (ProgramOptions::LoadOnlineSafeModsOnly && !globalLooseMod.IsSafeForOnline) {
+            std::cout << Colors::Red << "WARNING: " << Colors::Reset << "Loose mod files are not safe for public matchmaking, skipping" << '\n';
+        }
+        else {
+            std::cout << "Found " << Colors::Blue << looseModFiles.Count << " file(s) " << Colors::Reset << "in " << Colors::Yellow << "'Mods' " << Colors::Reset << "folder..." << '\n';
+
+            if (!globalLooseMod.IsSafeForOnline) {
+                std::cout << Colors::Yellow << "WARNING: Loose mod files are not safe for online play, public matchmaking will be disabled" << Colors::Reset << '\n';
+            }
+        }
+    }
+
+    mtx.unlock();
 }
@@ -16,44 +16,133 @@
 * along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <filesystem>
 #include <iostream>
 #include <sstream>
+#include <deque>
 #include <mutex>
 #include "AddChunks.hpp"
 #include "Colors.hpp"
+#include "MemoryBudget.hpp"
 #include "MemoryMappedFile.hpp"
 #include "ProgramOptions.hpp"
 #include "ReadResourceFile.hpp"
 #include "ReadSoundEntries.hpp"
 #include "ReplaceChunks.hpp"
 #include "ReplaceSounds.hpp"
+#include "ResourceTocCache.hpp"
 #include "WriteStreamDB.hpp"
 #include "LoadMods.hpp"
 
+namespace fs = std::filesystem;
+
 extern std::mutex mtx;
 
-// String streams for output
-std::vector<std::stringstream> StringStreams;
-size_t StreamIndex{0};
+// String streams for output, one per container in the order they were injected
+std::deque<std::stringstream> StringStreams;
+size_t OutputStreamCount{0};
+
+// Get a new stream for a container's output, in the order the containers are started
+std::stringstream& NewStringStream()
+{
+    mtx.lock();
+    std::stringstream& os = StringStreams.emplace_back();
+    mtx.unlock();
+
+    return os;
+}
+
+// Print the output of the containers injected since the last call
+void OutputStringStreams()
+{
+    mtx.lock();
+
+    // Inserting an empty buffer would set failbit on std::cout, silencing everything after it
+    for (; OutputStreamCount < StringStreams.size(); OutputStreamCount++) {
+        if (StringStreams[OutputStreamCount].tellp() > 0) {
+            std::cout << StringStreams[OutputStreamCount].rdbuf();
+        }
+    }
+
+    mtx.unlock();
+}
+
+// Memory budget for the mod data held by the loading and injection tasks, if limited
+std::unique_ptr<MemoryBudget> ModDataBudget;
+
+void InitMemoryBudget(size_t limit)
+{
+    ModDataBudget = std::make_unique<MemoryBudget>(limit);
+}
+
+// Tables of contents of the resource containers from the last runs, if enabled
+std::unique_ptr<ResourceTocCache> TocCache;
 
-void InitStringStreams(size_t count)
+void InitTocCache(const std::string& cachePath)
 {
-    StringStreams.resize(count);
+    TocCache = std::make_unique<ResourceTocCache>(cachePath);
 }
 
-void OutputStringStream(int index)
+bool SaveTocCache()
 {
-    std::cout << StringStreams[index].rdbuf();
+    return TocCache == nullptr || TocCache->Save();
+}
+
+// Estimate the mod data a container needs in memory while it's injected
+static size_t GetModDataSize(const ResourceContainer& resourceContainer)
+{
+    size_t modDataSize = 0;
+
+    for (const auto& modFile : resourceContainer.ModFileList) {
+        modDataSize += modFile.FileBytes.size();
+    }
+
+    return modDataSize;
+}
+
+// Adding chunks rebuilds the container's tables in memory, the data section is moved in place
+static size_t GetAddChunksDataSize(const ResourceContainer& resourceContainer)
+{
+    if (resourceContainer.NewModFileList.empty()) {
+        return 0;
+    }
+
+    size_t modDataSize = resourceContainer.DataOffset;
+
+    for (const auto& modFile : resourceContainer.NewModFileList) {
+        modDataSize += modFile.FileBytes.size();
+    }
+
+    return modDataSize;
+}
+
+static size_t GetModDataSize(const SoundContainer& soundContainer)
+{
+    size_t modDataSize = 0;
+
+    for (const auto& modFile : soundContainer.ModFileList) {
+        modDataSize += modFile.FileBytes.size();
+    }
+
+    return modDataSize;
+}
+
+static size_t GetModDataSize(const StreamDBContainer& streamDBContainer)
+{
+    size_t modDataSize = 0;
+
+    for (const auto& modFile : streamDBContainer.ModFiles) {
+        modDataSize += modFile.FileData.size();
+    }
+
+    return modDataSize;
 }
 
 void LoadResourceMods(ResourceContainer& resourceContainer,
-    std::map<uint64_t, ResourceDataEntry>& resourceDataMap,
-    std::unique_ptr<std::byte[]>& buffer, int bufferSize)
+    std::map<uint64_t, ResourceDataEntry>& resourceDataMap, ThreadPool *threadPool, std::stringstream& os)
 {
-    // Get stringstream to store output
-    mtx.lock();
-    std::stringstream& os = StringStreams[StreamIndex++];
-    mtx.unlock();
+    // Wait until the mod data fits in the memory budget
+    MemoryReservation memoryReservation(ModDataBudget.get(), GetModDataSize(resourceContainer));
 
     if (!ProgramOptions::MultiThreading) {
         // Redirect output to stdout directly
@@ -71,18 +160,26 @@ void LoadResourceMods(ResourceContainer& resourceContainer,
         return;
     }
 
+    // Read the container, unless it's unchanged since it was cached
+    if (TocCache == nullptr || !TocCache->Load(*memoryMappedFile, resourceContainer)) {
+        ReadResource(*memoryMappedFile, resourceContainer, threadPool);
+
+        if (TocCache != nullptr) {
+            TocCache->Store(*memoryMappedFile, resourceContainer);
+        }
+    }
+
     // Load mods
-    ReadResource(*memoryMappedFile, resourceContainer);
-    ReplaceChunks(*memoryMappedFile, resourceContainer, resourceDataMap, os, buffer, bufferSize);
+    ReplaceChunks(*memoryMappedFile, resourceContainer, resourceDataMap, threadPool, os);
+
+    memoryReservation.Update(GetAddChunksDataSize(resourceContainer));
     AddChunks(*memoryMappedFile, resourceContainer, resourceDataMap, os);
 }
 
-void LoadSoundMods(SoundContainer& soundContainer)
+void LoadSoundMods(SoundContainer& soundContainer, std::stringstream& os)
 {
-    // Get stringstream to store output
-    mtx.lock();
-    std::stringstream& os = StringStreams[StreamIndex++];
-    mtx.unlock();
+    // Wait until the mod data fits in the memory budget
+    MemoryReservation memoryReservation(ModDataBudget.get(), GetModDataSize(soundContainer));
 
     if (!ProgramOptions::MultiThreading) {
         // Redirect output to stdout directly
@@ -105,12 +202,10 @@ void LoadSoundMods(SoundContainer& soundContainer)
     ReplaceSounds(*memoryMappedFile, soundContainer, os);
 }
 
-void LoadStreamDBMods(StreamDBContainer& streamDBContainer, std::vector<StreamDBContainer>& streamDBContainerList)
+void LoadStreamDBMods(StreamDBContainer& streamDBContainer, std::stringstream& os)
 {
-    // Get stringstream to store output
-    mtx.lock();
-    std::stringstream& os = StringStreams[StreamIndex++];
-    mtx.unlock();
+    // Wait until the mod data fits in the memory budget
+    MemoryReservation memoryReservation(ModDataBudget.get(), GetModDataSize(streamDBContainer));
 
     if (!ProgramOptions::MultiThreading) {
         // Redirect output to stdout directly
@@ -129,8 +224,17 @@ void LoadStreamDBMods(StreamDBContainer& streamDBContainer, std::vector<StreamDB
     }
 
     // Write the custom streamdb file
-    WriteStreamDBFile(streamDBFile, streamDBContainer, streamDBContainerList, os);
+    bool isBuilt = WriteStreamDBFile(streamDBFile, streamDBContainer, os);
 
     // Close file
     fclose(streamDBFile);
+
+    // Don't leave a corrupt streamdb file behind
+    if (!isBuilt) {
+        std::error_code ec;
+        fs::remove(streamDBContainer.Path, ec);
+
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to build \"" << streamDBContainer.Name << "\" file.\n";
+        streamDBContainer.BuildFailed = true;
+    }
 }
@@ -0,0 +1,43 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include "MemoryBudget.hpp"
+
+// Wait until the bytes fit in the budget and reserve them
+// Returns the number of bytes actually reserved, to be released later
+size_t MemoryBudget::Acquire(size_t bytes)
+{
+    bytes = std::min(bytes, Limit);
+
+    std::unique_lock<std::mutex> lock(Mutex);
+    BytesReleased.wait(lock, [this, bytes] { return Used + bytes <= Limit; });
+    Used += bytes;
+
+    return bytes;
+}
+
+void MemoryBudget::Release(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        Used -= bytes;
+    }
+
+    BytesReleased.notify_all();
+}
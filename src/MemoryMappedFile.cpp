@@ -16,6 +16,7 @@
 * along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 #include "MemoryMappedFile.hpp"
@@ -28,11 +29,12 @@
 
 namespace fs = std::filesystem;
 
-MemoryMappedFile::MemoryMappedFile(const std::string filePath)
+MemoryMappedFile::MemoryMappedFile(const std::string filePath, const bool readOnly)
 {
     // Get filepath and size
     FilePath = filePath;
     Size = fs::file_size(FilePath);
+    ReadOnly = readOnly;
 
     if (Size <= 0) {
         throw std::exception();
@@ -40,14 +42,15 @@ MemoryMappedFile::MemoryMappedFile(const std::string filePath)
 
 #ifdef _WIN32
     // Get file handle
-    FileHandle = CreateFileA(FilePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    FileHandle = CreateFileA(FilePath.c_str(), ReadOnly ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, ReadOnly ? FILE_SHARE_READ : 0,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 
     if (GetLastError() != ERROR_SUCCESS || FileHandle == INVALID_HANDLE_VALUE) {
         throw std::exception();
     }
 
     // Map file into memory
-    FileMapping = CreateFileMappingA(FileHandle, nullptr, PAGE_READWRITE,
+    FileMapping = CreateFileMappingA(FileHandle, nullptr, ReadOnly ? PAGE_READONLY : PAGE_READWRITE,
         *(reinterpret_cast<DWORD*>(&Size) + 1), *reinterpret_cast<DWORD*>(&Size), nullptr);
 
     if (GetLastError() != ERROR_SUCCESS || FileMapping == nullptr) {
@@ -56,31 +59,62 @@ MemoryMappedFile::MemoryMappedFile(const std::string filePath)
     }
 
     // Get memory view of file
-    Mem = reinterpret_cast<std::byte*>(MapViewOfFile(FileMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    Mem = reinterpret_cast<std::byte*>(MapViewOfFile(FileMapping, ReadOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS, 0, 0, 0));
 
     if (GetLastError() != ERROR_SUCCESS || Mem == nullptr) {
         CloseHandle(FileHandle);
         CloseHandle(FileMapping);
         throw std::exception();
     }
+
+    // Read-only views can't be resized, so the handles aren't needed anymore
+    if (ReadOnly) {
+        CloseHandle(FileMapping);
+        CloseHandle(FileHandle);
+        FileMapping = nullptr;
+        FileHandle = nullptr;
+    }
 #else
     // Get file descriptor
-    FileDescriptor = open(FilePath.c_str(), O_RDWR);
+    FileDescriptor = open(FilePath.c_str(), ReadOnly ? O_RDONLY : O_RDWR);
 
     if (FileDescriptor == -1) {
         throw std::exception();
     }
 
     // Map file into memory
-    Mem = reinterpret_cast<std::byte*>(mmap(0, Size, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0));
+    Mem = reinterpret_cast<std::byte*>(mmap(0, Size, ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0));
 
-    if (Mem == nullptr) {
+    if (Mem == MAP_FAILED) {
         close(FileDescriptor);
         throw std::exception();
     }
 
+    MappedSize = Size;
+
+    // Read-only maps can't be resized, so the file descriptor isn't needed anymore
+    if (ReadOnly) {
+        close(FileDescriptor);
+        FileDescriptor = -1;
+    }
+
     // Prepare memory for usage
-    madvise(Mem, Size, MADV_WILLNEED);
+    madvise(Mem, Size, ReadOnly ? MADV_SEQUENTIAL : MADV_WILLNEED);
+#endif
+}
+
+// Release the pages of a read-only range from memory, they're read from the file again if needed
+void MemoryMappedFile::DropPages(const size_t offset, const size_t length)
+{
+#ifndef _WIN32
+    if (!ReadOnly || length == 0) {
+        return;
+    }
+
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t start = offset / pageSize * pageSize;
+
+    madvise(Mem + start, offset + length - start, MADV_DONTNEED);
 #endif
 }
 
@@ -95,12 +129,18 @@ void MemoryMappedFile::UnmapFile()
 #ifdef _WIN32
     // Unmap memory view and close handles
     UnmapViewOfFile(Mem);
-    CloseHandle(FileMapping);
-    CloseHandle(FileHandle);
+
+    if (!ReadOnly) {
+        CloseHandle(FileMapping);
+        CloseHandle(FileHandle);
+    }
 #else
     // Unmap file and close handle
-    munmap(Mem, fs::file_size(FilePath));
-    close(FileDescriptor);
+    munmap(Mem, MappedSize);
+
+    if (!ReadOnly) {
+        close(FileDescriptor);
+    }
 #endif
 
     // Reset object data
@@ -111,6 +151,10 @@ void MemoryMappedFile::UnmapFile()
 
 bool MemoryMappedFile::ResizeFile(const size_t newSize)
 {
+    if (ReadOnly) {
+        return false;
+    }
+
     try {
 #ifdef _WIN32
         // Unmap memory view and close mapping handle
@@ -131,11 +175,8 @@ bool MemoryMappedFile::ResizeFile(const size_t newSize)
             return false;
         }
 #else
-        // Unmap file
-        munmap(Mem, Size);
-
-        // Resize file
-        if (fallocate(FileDescriptor, 0, 0, newSize) != 0) {
+        // Resize file, only allocating the range it grows by
+        if (newSize <= Size || fallocate(FileDescriptor, 0, Size, newSize - Size) != 0) {
             auto fallocateErrorCode = errno;
             if (ftruncate(FileDescriptor, newSize) != 0) {
                 std::cerr << "Cannot increase size of file " << FilePath<< ", fallocate failed with code " << fallocateErrorCode << ", ftruncate failed with code " << errno << ". Make sure you have enough disk space and write permissions for game files.\n";
@@ -143,15 +184,30 @@ bool MemoryMappedFile::ResizeFile(const size_t newSize)
             }
         }
 
-        // Remap file
-        Mem = reinterpret_cast<std::byte*>(mmap(0, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0));
+        // Shrink the mapping with the file, so the range past the new end isn't mapped anymore instead of faulting
+        if (newSize < Size && newSize != 0) {
+            void *newMem = mremap(Mem, MappedSize, newSize, 0);
 
-        if (Mem == nullptr) {
-            return false;
+            if (newMem == MAP_FAILED) {
+                return false;
+            }
+
+            MappedSize = newSize;
         }
 
-        // Prepare memory for usage
-        madvise(Mem, newSize, MADV_WILLNEED);
+        // Grow the mapping geometrically, the pages past the end of the file are never touched
+        // Only the mapping itself is extended, so the mapped pages and the readahead of the file are kept
+        if (newSize > MappedSize) {
+            size_t newMappedSize = std::max(newSize, MappedSize * 2);
+            void *newMem = mremap(Mem, MappedSize, newMappedSize, MREMAP_MAYMOVE);
+
+            if (newMem == MAP_FAILED) {
+                return false;
+            }
+
+            Mem = reinterpret_cast<std::byte*>(newMem);
+            MappedSize = newMappedSize;
+        }
 #endif
     }
     catch (...) {
@@ -0,0 +1,272 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <filesystem>
+#include "ProgramOptions.hpp"
+#include "ModFileBytes.hpp"
+#include "miniz/miniz.h"
+
+// Inflate the next bytes of a raw deflate stream into the given buffer
+static bool InflateTo(mz_stream& stream, const std::byte *&source, size_t& sourceRemaining, std::byte *destination, size_t count)
+{
+    while (count > 0) {
+        // Feed the input in chunks, as the stream sizes are 32-bit
+        if (stream.avail_in == 0 && sourceRemaining > 0) {
+            unsigned int inputChunk = static_cast<unsigned int>(std::min<size_t>(sourceRemaining, INT_MAX));
+            stream.next_in = reinterpret_cast<const unsigned char*>(source);
+            stream.avail_in = inputChunk;
+            source += inputChunk;
+            sourceRemaining -= inputChunk;
+        }
+
+        unsigned int outputChunk = static_cast<unsigned int>(std::min<size_t>(count, INT_MAX));
+        stream.next_out = reinterpret_cast<unsigned char*>(destination);
+        stream.avail_out = outputChunk;
+
+        int status = mz_inflate(&stream, MZ_SYNC_FLUSH);
+        size_t produced = outputChunk - stream.avail_out;
+        destination += produced;
+        count -= produced;
+
+        if (status == MZ_STREAM_END) {
+            return count == 0;
+        }
+
+        if ((status != MZ_OK && status != MZ_BUF_ERROR) || (produced == 0 && stream.avail_in == 0 && sourceRemaining == 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Inflate a deflated zip entry into the given buffer, skipping the first bytes of output
+// The checksum is only verified when the whole entry is inflated
+static bool InflateZipEntry(const std::byte *source, size_t sourceLength, size_t skip, std::byte *destination, size_t count,
+    const bool verify, const uint32_t expectedCrc32)
+{
+    mz_stream stream;
+    std::fill(reinterpret_cast<std::byte*>(&stream), reinterpret_cast<std::byte*>(&stream) + sizeof(stream), std::byte{0});
+
+    if (mz_inflateInit2(&stream, -MZ_DEFAULT_WINDOW_BITS) != MZ_OK) {
+        return false;
+    }
+
+    bool success = true;
+    mz_ulong crc = MZ_CRC32_INIT;
+    std::byte skipBuffer[4096];
+
+    // Inflate and discard the skipped bytes
+    while (success && skip > 0) {
+        size_t toSkip = std::min(skip, sizeof(skipBuffer));
+        success = InflateTo(stream, source, sourceLength, skipBuffer, toSkip);
+        crc = mz_crc32(crc, reinterpret_cast<const unsigned char*>(skipBuffer), toSkip);
+        skip -= toSkip;
+    }
+
+    if (success) {
+        success = InflateTo(stream, source, sourceLength, destination, count);
+    }
+
+    if (success && verify) {
+        if (count > 0) {
+            crc = mz_crc32(crc, reinterpret_cast<const unsigned char*>(destination), count);
+        }
+
+        success = crc == expectedCrc32;
+    }
+
+    mz_inflateEnd(&stream);
+    return success;
+}
+
+// Read a range of a file straight into the given buffer
+static bool ReadFileRange(const std::string& filePath, const size_t offset, std::byte *destination, const size_t count)
+{
+    FILE *file = fopen(filePath.c_str(), "rb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    // Mod files can be larger than what a long can hold on some platforms
+#ifdef _WIN32
+    bool success = _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    bool success = fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+
+    success = success && fread(destination, 1, count, file) == count;
+    fclose(file);
+
+    return success;
+}
+
+// Drop the first bytes without copying the rest
+void ModFileBytes::RemovePrefix(const size_t count)
+{
+    if (Deflated) {
+        Skip += count;
+    }
+    else {
+        Offset += count;
+    }
+
+    Length -= count;
+}
+
+// Copy the first bytes, inflating only as much as needed
+bool ModFileBytes::Peek(std::byte *destination, const size_t count) const
+{
+    if (count > Length) {
+        return false;
+    }
+
+    if (Deflated) {
+        return InflateZipEntry(Archive->Mem + Offset, CompressedLength, Skip, destination, count, false, 0);
+    }
+
+    if (!FilePath.empty()) {
+        return ReadFileRange(FilePath, Offset, destination, count);
+    }
+
+    std::copy(data(), data() + count, destination);
+    return true;
+}
+
+// Copy all the bytes, inflating or reading them straight into the destination if needed
+bool ModFileBytes::CopyTo(std::byte *destination) const
+{
+    return CopyTo(destination, 0, Length);
+}
+
+// Copy a range of the bytes, inflating or reading them straight into the destination if needed
+// Deflated data's checksum is only verified when the range reaches the end
+bool ModFileBytes::CopyTo(std::byte *destination, const size_t offset, const size_t count) const
+{
+    if (offset > Length || count > Length - offset) {
+        return false;
+    }
+
+    InjectedBytes += count;
+
+    if (!FilePath.empty()) {
+        return ReadFileRange(FilePath, Offset + offset, destination, count);
+    }
+
+    bool success = true;
+    bool reachesEnd = offset + count == Length;
+
+    if (Deflated) {
+        success = InflateZipEntry(Archive->Mem + Offset, CompressedLength, Skip + offset, destination, count, reachesEnd, Crc32);
+    }
+    else {
+        CopiedBytes += count;
+        std::copy(begin() + offset, begin() + offset + count, destination);
+    }
+
+    // With a memory budget, don't keep the archive's pages around once they're in the container
+    if (ProgramOptions::MaxMemory != 0 && Archive != nullptr) {
+        if (!Deflated) {
+            Archive->DropPages(Offset + offset, count);
+        }
+        else if (reachesEnd) {
+            Archive->DropPages(Offset, CompressedLength);
+        }
+    }
+
+    return success;
+}
+
+// Write all the bytes to a file
+bool ModFileBytes::WriteTo(FILE *file) const
+{
+    return WriteTo(file, 0, Length);
+}
+
+// Write a range of the bytes to a file, straight from memory if they're there
+bool ModFileBytes::WriteTo(FILE *file, const size_t offset, const size_t count) const
+{
+    if (offset > Length || count > Length - offset) {
+        return false;
+    }
+
+    if (!IsDeferred()) {
+        InjectedBytes += count;
+        CopiedBytes += count;
+        bool success = fwrite(data() + offset, 1, count, file) == count;
+
+        // With a memory budget, don't keep the archive's pages around once they're written
+        if (ProgramOptions::MaxMemory != 0 && Archive != nullptr) {
+            Archive->DropPages(Offset + offset, count);
+        }
+
+        return success;
+    }
+
+    // Deferred bytes only need a buffer for the range being written
+    std::vector<std::byte> buffer(count);
+
+    if (!CopyTo(buffer.data(), offset, count)) {
+        return false;
+    }
+
+    return fwrite(buffer.data(), 1, count, file) == count;
+}
+
+// Check deferred bytes can still be read, inflating deflated ones without keeping the data
+bool ModFileBytes::Verify() const
+{
+    if (Deflated) {
+        return InflateZipEntry(Archive->Mem + Offset, CompressedLength, Skip + Length, nullptr, 0, true, Crc32);
+    }
+
+    if (!FilePath.empty()) {
+        std::error_code ec;
+        uintmax_t fileSize = std::filesystem::file_size(FilePath, ec);
+        return !ec && fileSize >= Offset + Length;
+    }
+
+    return true;
+}
+
+// Inflate or read deferred bytes into memory, so they can be accessed directly
+bool ModFileBytes::Load()
+{
+    if (!IsDeferred()) {
+        return true;
+    }
+
+    std::vector<std::byte> bytes(Length);
+
+    if (!FilePath.empty() ? !ReadFileRange(FilePath, Offset, bytes.data(), Length)
+        : !InflateZipEntry(Archive->Mem + Offset, CompressedLength, Skip, bytes.data(), Length, true, Crc32)) {
+        return false;
+    }
+
+    *this = ModFileBytes(std::move(bytes));
+    return true;
+}
+
+void ModFileBytes::clear()
+{
+    *this = ModFileBytes();
+}
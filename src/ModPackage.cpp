@@ -0,0 +1,555 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "Colors.hpp"
+#include "Mod.hpp"
+#include "Oodle.hpp"
+#include "Utils.hpp"
+#include "ModPackage.hpp"
+#include "jsonxx/jsonxx.h"
+#include "miniz/miniz.h"
+
+namespace fs = std::filesystem;
+
+// Package layout
+const char PackageMagic[8] = { 'E', 'M', 'L', 'P', 'A', 'C', 'K', '\0' };
+const size_t PackageHeaderSize = 0x40;
+const size_t PackageEntrySize = 0x40;
+const size_t PackagePayloadAlignment = 0x1000;
+
+template<typename T>
+static void WriteValue(std::vector<std::byte>& bytes, const T value)
+{
+    bytes.insert(bytes.end(), reinterpret_cast<const std::byte*>(&value), reinterpret_cast<const std::byte*>(&value) + sizeof(T));
+}
+
+static void WriteString(std::vector<std::byte>& bytes, const std::string& string)
+{
+    WriteValue<uint32_t>(bytes, string.size());
+    bytes.insert(bytes.end(), reinterpret_cast<const std::byte*>(string.data()), reinterpret_cast<const std::byte*>(string.data()) + string.size());
+}
+
+// Read a value, throwing if it's out of bounds
+template<typename T>
+static T ReadValue(const std::byte *data, const size_t size, size_t& pos)
+{
+    if (pos > size || sizeof(T) > size - pos) {
+        throw std::exception();
+    }
+
+    T value;
+    std::copy(data + pos, data + pos + sizeof(T), reinterpret_cast<std::byte*>(&value));
+    pos += sizeof(T);
+    return value;
+}
+
+static std::string ReadString(const std::byte *data, const size_t size, size_t& pos)
+{
+    auto length = ReadValue<uint32_t>(data, size, pos);
+
+    if (length > size - pos) {
+        throw std::exception();
+    }
+
+    std::string string(reinterpret_cast<const char*>(data) + pos, length);
+    pos += length;
+    return string;
+}
+
+static bool IsInRange(const uint64_t offset, const uint64_t length, const uint64_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+static std::vector<std::byte> AssetsInfoToByteVector(const AssetsInfo& assetsInfo)
+{
+    std::vector<std::byte> bytes;
+
+    WriteValue<uint32_t>(bytes, assetsInfo.Layers.size());
+
+    for (const auto& layer : assetsInfo.Layers) {
+        WriteString(bytes, layer.Name);
+    }
+
+    WriteValue<uint32_t>(bytes, assetsInfo.Maps.size());
+
+    for (const auto& map : assetsInfo.Maps) {
+        WriteString(bytes, map.Name);
+    }
+
+    WriteValue<uint32_t>(bytes, assetsInfo.Resources.size());
+
+    for (const auto& resource : assetsInfo.Resources) {
+        WriteString(bytes, resource.Name);
+        WriteValue<uint8_t>(bytes, resource.Remove);
+        WriteValue<uint8_t>(bytes, resource.PlaceFirst);
+        WriteValue<uint8_t>(bytes, resource.PlaceBefore);
+        WriteString(bytes, resource.PlaceByName);
+    }
+
+    WriteValue<uint32_t>(bytes, assetsInfo.Assets.size());
+
+    for (const auto& asset : assetsInfo.Assets) {
+        WriteValue<uint64_t>(bytes, asset.StreamDbHash);
+        WriteString(bytes, asset.ResourceType);
+        WriteValue<std::byte>(bytes, asset.Version);
+        WriteString(bytes, asset.Name);
+        WriteString(bytes, asset.MapResourceType);
+        WriteValue<uint8_t>(bytes, asset.Remove);
+        WriteValue<uint8_t>(bytes, asset.PlaceBefore);
+        WriteString(bytes, asset.PlaceByName);
+        WriteString(bytes, asset.PlaceByType);
+        WriteValue<std::byte>(bytes, asset.SpecialByte1);
+        WriteValue<std::byte>(bytes, asset.SpecialByte2);
+        WriteValue<std::byte>(bytes, asset.SpecialByte3);
+    }
+
+    return bytes;
+}
+
+// Parse a strings JSON, failing if any string is missing its name or text
+static bool ParseBlangJson(const std::vector<std::byte>& blangJsonBytes, std::vector<std::byte>& blangStringsBytes)
+{
+    try {
+        jsonxx::Object blangJson;
+
+        if (!blangJson.parse(std::string(reinterpret_cast<const char*>(blangJsonBytes.data()), blangJsonBytes.size()))
+        || !blangJson.has<jsonxx::Array>("strings")) {
+            return false;
+        }
+
+        jsonxx::Array blangJsonStrings = blangJson.get<jsonxx::Array>("strings");
+        blangStringsBytes.clear();
+        WriteValue<uint32_t>(blangStringsBytes, blangJsonStrings.size());
+
+        for (size_t i = 0; i < blangJsonStrings.size(); i++) {
+            if (!blangJsonStrings.has<jsonxx::Object>(i)) {
+                return false;
+            }
+
+            jsonxx::Object blangJsonString = blangJsonStrings.get<jsonxx::Object>(i);
+
+            if (!blangJsonString.has<jsonxx::String>("name") || !blangJsonString.has<jsonxx::String>("text")) {
+                return false;
+            }
+
+            WriteString(blangStringsBytes, blangJsonString.get<jsonxx::String>("name"));
+            WriteString(blangStringsBytes, blangJsonString.get<jsonxx::String>("text"));
+        }
+    }
+    catch (...) {
+        return false;
+    }
+
+    return true;
+}
+
+// Extract a zip entry straight into a byte vector
+static bool ExtractZipEntry(mz_zip_archive& modZip, const unsigned int index, std::vector<std::byte>& bytes)
+{
+    mz_zip_archive_file_stat zipEntryStat;
+
+    if (!mz_zip_reader_file_stat(&modZip, index, &zipEntryStat)) {
+        return false;
+    }
+
+    bytes.resize(zipEntryStat.m_uncomp_size);
+    return mz_zip_reader_extract_to_mem(&modZip, index, bytes.data(), bytes.size(), 0);
+}
+
+ModPackage::ModPackage(const std::string& packagePath)
+{
+    Package = std::make_shared<MemoryMappedFile>(packagePath, true);
+    const std::byte *data = Package->Mem;
+    size_t size = Package->Size;
+
+    // Read the header
+    if (size < PackageHeaderSize || std::memcmp(data, PackageMagic, sizeof(PackageMagic)) != 0) {
+        throw std::exception();
+    }
+
+    size_t pos = sizeof(PackageMagic);
+    auto version = ReadValue<uint32_t>(data, size, pos);
+    auto entryCount = ReadValue<uint32_t>(data, size, pos);
+    auto stringsOffset = ReadValue<uint64_t>(data, size, pos);
+    auto stringsSize = ReadValue<uint64_t>(data, size, pos);
+    LoadPriority = ReadValue<int32_t>(data, size, pos);
+    RequiredVersion = ReadValue<int32_t>(data, size, pos);
+
+    if (version != PACKAGE_VERSION || !IsInRange(stringsOffset, stringsSize, size)
+    || !IsInRange(PackageHeaderSize, static_cast<uint64_t>(entryCount) * PackageEntrySize, size)) {
+        throw std::exception();
+    }
+
+    // Read the routing table
+    const char *strings = reinterpret_cast<const char*>(data) + stringsOffset;
+    Entries.resize(entryCount);
+
+    for (size_t i = 0; i < Entries.size(); i++) {
+        auto& entry = Entries[i];
+        pos = PackageHeaderSize + i * PackageEntrySize;
+
+        auto resourceNameOffset = ReadValue<uint32_t>(data, size, pos);
+        auto resourceNameLength = ReadValue<uint32_t>(data, size, pos);
+        auto nameOffset = ReadValue<uint32_t>(data, size, pos);
+        auto nameLength = ReadValue<uint32_t>(data, size, pos);
+        entry.DataOffset = ReadValue<uint64_t>(data, size, pos);
+        entry.DataSize = ReadValue<uint64_t>(data, size, pos);
+        entry.TextureOffset = ReadValue<uint64_t>(data, size, pos);
+        entry.TextureSize = ReadValue<uint64_t>(data, size, pos);
+        entry.Flags = ReadValue<uint32_t>(data, size, pos);
+
+        if (!IsInRange(resourceNameOffset, resourceNameLength, stringsSize) || !IsInRange(nameOffset, nameLength, stringsSize)
+        || !IsInRange(entry.DataOffset, entry.DataSize, size) || !IsInRange(entry.TextureOffset, entry.TextureSize, size)) {
+            throw std::exception();
+        }
+
+        entry.ResourceName = std::string(strings + resourceNameOffset, resourceNameLength);
+        entry.Name = std::string(strings + nameOffset, nameLength);
+    }
+}
+
+AssetsInfo ModPackage::ReadAssetsInfo(const PackageEntry& entry) const
+{
+    const std::byte *data = Package->Mem + entry.DataOffset;
+    size_t size = entry.DataSize;
+    size_t pos = 0;
+    class AssetsInfo assetsInfo;
+
+    assetsInfo.Layers.resize(ReadValue<uint32_t>(data, size, pos));
+
+    for (auto& layer : assetsInfo.Layers) {
+        layer.Name = ReadString(data, size, pos);
+    }
+
+    assetsInfo.Maps.resize(ReadValue<uint32_t>(data, size, pos));
+
+    for (auto& map : assetsInfo.Maps) {
+        map.Name = ReadString(data, size, pos);
+    }
+
+    assetsInfo.Resources.resize(ReadValue<uint32_t>(data, size, pos));
+
+    for (auto& resource : assetsInfo.Resources) {
+        resource.Name = ReadString(data, size, pos);
+        resource.Remove = ReadValue<uint8_t>(data, size, pos) != 0;
+        resource.PlaceFirst = ReadValue<uint8_t>(data, size, pos) != 0;
+        resource.PlaceBefore = ReadValue<uint8_t>(data, size, pos) != 0;
+        resource.PlaceByName = ReadString(data, size, pos);
+    }
+
+    assetsInfo.Assets.resize(ReadValue<uint32_t>(data, size, pos));
+
+    for (auto& asset : assetsInfo.Assets) {
+        asset.StreamDbHash = ReadValue<uint64_t>(data, size, pos);
+        asset.ResourceType = ReadString(data, size, pos);
+        asset.Version = ReadValue<std::byte>(data, size, pos);
+        asset.Name = ReadString(data, size, pos);
+        asset.MapResourceType = ReadString(data, size, pos);
+        asset.Remove = ReadValue<uint8_t>(data, size, pos) != 0;
+        asset.PlaceBefore = ReadValue<uint8_t>(data, size, pos) != 0;
+        asset.PlaceByName = ReadString(data, size, pos);
+        asset.PlaceByType = ReadString(data, size, pos);
+        asset.SpecialByte1 = ReadValue<std::byte>(data, size, pos);
+        asset.SpecialByte2 = ReadValue<std::byte>(data, size, pos);
+        asset.SpecialByte3 = ReadValue<std::byte>(data, size, pos);
+    }
+
+    return assetsInfo;
+}
+
+std::vector<BlangString> ModPackage::ReadBlangStrings(const PackageEntry& entry) const
+{
+    const std::byte *data = Package->Mem + entry.DataOffset;
+    size_t size = entry.DataSize;
+    size_t pos = 0;
+    std::vector<BlangString> blangStrings(ReadValue<uint32_t>(data, size, pos));
+
+    for (auto& blangString : blangStrings) {
+        blangString.Identifier = ReadString(data, size, pos);
+        blangString.Text = ReadString(data, size, pos);
+    }
+
+    return blangStrings;
+}
+
+bool ModPackage::Pack(const std::string& zippedMod, const std::string& packagePath, std::stringstream& os)
+{
+    // Map the zipped mod
+    std::unique_ptr<MemoryMappedFile> modArchive;
+
+    try {
+        modArchive = std::make_unique<MemoryMappedFile>(zippedMod, true);
+    }
+    catch (...) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << zippedMod << " for reading." << '\n';
+        return false;
+    }
+
+    mz_zip_archive modZip;
+    mz_zip_zero_struct(&modZip);
+
+    if (!mz_zip_reader_init_mem(&modZip, modArchive->Mem, modArchive->Size, 0)) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to read zip file " << zippedMod << '\n';
+        return false;
+    }
+
+    // Pre-parse the mod info from the EternalMod JSON if it exists
+    Mod mod;
+    char *unzippedModJson;
+    size_t unzippedModJsonSize;
+
+    if ((unzippedModJson = static_cast<char*>(mz_zip_reader_extract_file_to_heap(&modZip, "EternalMod.json", &unzippedModJsonSize, 0))) != nullptr) {
+        std::string modJson(unzippedModJson, unzippedModJsonSize);
+        free(unzippedModJson);
+
+        try {
+            mod = Mod(modJson);
+        }
+        catch (...) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod.json - using defaults." << '\n';
+        }
+    }
+
+    // Build the routing table, the same way zipped mods are routed
+    std::vector<PackageEntry> entries;
+    std::vector<unsigned int> zipEntryIndexes;
+    std::vector<std::vector<std::byte>> parsedPayloads;
+
+    for (unsigned int i = 0; i < modZip.m_total_files; i++) {
+        unsigned int zipEntryNameSize = mz_zip_reader_get_filename(&modZip, i, nullptr, 0);
+        auto zipEntryNameBuffer = std::make_unique<char[]>(zipEntryNameSize);
+
+        if (mz_zip_reader_get_filename(&modZip, i, zipEntryNameBuffer.get(), zipEntryNameSize) != zipEntryNameSize || zipEntryNameSize == 0) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to read zip file entry from " << zippedMod << '\n';
+            continue;
+        }
+
+        std::string zipEntryName(zipEntryNameBuffer.get());
+
+        // Skip directories
+        if (0 == zipEntryName.compare(zipEntryName.length() - 1, 1, "/")) {
+            continue;
+        }
+
+        std::vector<std::string> modFilePathParts = SplitString(zipEntryName, '/');
+
+        if (modFilePathParts.size() < 2) {
+            continue;
+        }
+
+        PackageEntry entry;
+        entry.ResourceName = modFilePathParts[0];
+        entry.Name = zipEntryName;
+
+        // Old mods compatibility
+        if (ToLower(entry.ResourceName) == "generated") {
+            entry.ResourceName = "gameresources";
+        }
+        else {
+            entry.Name = zipEntryName.substr(entry.ResourceName.size() + 1);
+        }
+
+        if (modFilePathParts.size() > 2 && modFilePathParts[1] == "EternalMod" && modFilePathParts[2] == "strings") {
+            entry.Flags |= RedirectableEntry;
+        }
+
+        // Pre-parse the JSON files under 'EternalMod'
+        std::vector<std::byte> parsedPayload;
+
+        if (ToLower(modFilePathParts[1]) == "eternalmod") {
+            bool isJson = modFilePathParts.size() == 4 && fs::path(modFilePathParts[3]).extension().string() == ".json";
+
+            if (isJson && ToLower(modFilePathParts[2]) == "assetsinfo") {
+                try {
+                    std::vector<std::byte> assetsInfoJson;
+
+                    if (!ExtractZipEntry(modZip, i, assetsInfoJson)) {
+                        throw std::exception();
+                    }
+
+                    parsedPayload = AssetsInfoToByteVector(AssetsInfo(std::string(reinterpret_cast<const char*>(assetsInfoJson.data()), assetsInfoJson.size())));
+                    entry.Flags |= AssetsInfoEntry;
+                }
+                catch (...) {
+                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod/assetsinfo/"
+                        << fs::path(entry.Name).stem().string() << ".json" << '\n';
+                    continue;
+                }
+            }
+            else if (isJson && ToLower(modFilePathParts[2]) == "strings") {
+                entry.Flags |= BlangJsonEntry;
+                std::vector<std::byte> blangJson;
+
+                // Malformed files are kept as JSON, to be reported when they're loaded
+                if (ExtractZipEntry(modZip, i, blangJson) && ParseBlangJson(blangJson, parsedPayload)) {
+                    entry.Flags |= ParsedBlangEntry;
+                }
+            }
+            else {
+                entry.Flags |= SkippedResourceEntry;
+            }
+        }
+
+        entries.push_back(std::move(entry));
+        zipEntryIndexes.push_back(i);
+        parsedPayloads.push_back(std::move(parsedPayload));
+    }
+
+    // Lay out the routing table and its names
+    std::vector<std::byte> strings;
+    std::vector<uint32_t> nameOffsets;
+
+    for (const auto& entry : entries) {
+        nameOffsets.push_back(strings.size());
+        strings.insert(strings.end(), reinterpret_cast<const std::byte*>(entry.ResourceName.data()),
+            reinterpret_cast<const std::byte*>(entry.ResourceName.data()) + entry.ResourceName.size());
+        nameOffsets.push_back(strings.size());
+        strings.insert(strings.end(), reinterpret_cast<const std::byte*>(entry.Name.data()),
+            reinterpret_cast<const std::byte*>(entry.Name.data()) + entry.Name.size());
+    }
+
+    uint64_t stringsOffset = PackageHeaderSize + entries.size() * PackageEntrySize;
+    uint64_t payloadsOffset = (stringsOffset + strings.size() + PackagePayloadAlignment - 1) / PackagePayloadAlignment * PackagePayloadAlignment;
+
+    // Write the payloads first, the tables are written once their offsets are known
+    std::string tempPackagePath = packagePath + ".tmp";
+    FILE *packageFile = fopen(tempPackagePath.c_str(), "wb");
+
+    if (!packageFile) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to open " << tempPackagePath << " for writing." << '\n';
+        mz_zip_reader_end(&modZip);
+        return false;
+    }
+
+    std::vector<std::byte> padding(PackagePayloadAlignment);
+    uint64_t packageSize = 0;
+    bool failed = false;
+
+    auto writePayload = [&](const std::byte *payload, const uint64_t payloadSize, uint64_t& payloadOffset) {
+        uint64_t paddingSize = packageSize % PackagePayloadAlignment == 0 ? 0 : PackagePayloadAlignment - packageSize % PackagePayloadAlignment;
+
+        if (fwrite(padding.data(), 1, paddingSize, packageFile) != paddingSize || fwrite(payload, 1, payloadSize, packageFile) != payloadSize) {
+            failed = true;
+        }
+
+        payloadOffset = packageSize + paddingSize;
+        packageSize = payloadOffset + payloadSize;
+    };
+
+    std::vector<std::byte> tableSpace(payloadsOffset);
+    failed = fwrite(tableSpace.data(), 1, tableSpace.size(), packageFile) != tableSpace.size();
+    packageSize = payloadsOffset;
+
+    std::vector<std::byte> payload;
+
+    for (size_t i = 0; i < entries.size() && !failed; i++) {
+        auto& entry = entries[i];
+
+        if ((entry.Flags & (AssetsInfoEntry | ParsedBlangEntry)) != 0) {
+            writePayload(parsedPayloads[i].data(), parsedPayloads[i].size(), entry.DataOffset);
+            entry.DataSize = parsedPayloads[i].size();
+            continue;
+        }
+
+        if (!ExtractZipEntry(modZip, zipEntryIndexes[i], payload)) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to extract zip entry from " << zippedMod << '\n';
+            failed = true;
+            break;
+        }
+
+        writePayload(payload.data(), payload.size(), entry.DataOffset);
+        entry.DataSize = payload.size();
+
+        // Precompute the compressed textures, unless they're compressed already
+        std::string lowercaseName = ToLower(entry.Name);
+
+        if ((EndsWith(lowercaseName, ".tga") || EndsWith(lowercaseName, ".png")) && !payload.empty()
+        && (payload.size() < 16 || std::memcmp(payload.data(), "DIVINITY", 8) != 0)) {
+            std::vector<std::byte> compressedTexture = Oodle::Compress(payload.data(), payload.size());
+
+            if (!compressedTexture.empty()) {
+                std::vector<std::byte> divinityTexture;
+                divinityTexture.reserve(16 + compressedTexture.size());
+                divinityTexture.insert(divinityTexture.end(), reinterpret_cast<const std::byte*>("DIVINITY"), reinterpret_cast<const std::byte*>("DIVINITY") + 8);
+                WriteValue<uint64_t>(divinityTexture, payload.size());
+                divinityTexture.insert(divinityTexture.end(), compressedTexture.begin(), compressedTexture.end());
+
+                writePayload(divinityTexture.data(), divinityTexture.size(), entry.TextureOffset);
+                entry.TextureSize = divinityTexture.size();
+            }
+        }
+    }
+
+    mz_zip_reader_end(&modZip);
+
+    // Write the header, routing table and string table
+    if (!failed) {
+        std::vector<std::byte> header;
+        header.reserve(payloadsOffset);
+        header.insert(header.end(), reinterpret_cast<const std::byte*>(PackageMagic), reinterpret_cast<const std::byte*>(PackageMagic) + sizeof(PackageMagic));
+        WriteValue<uint32_t>(header, PACKAGE_VERSION);
+        WriteValue<uint32_t>(header, entries.size());
+        WriteValue<uint64_t>(header, stringsOffset);
+        WriteValue<uint64_t>(header, strings.size());
+        WriteValue<int32_t>(header, mod.LoadPriority);
+        WriteValue<int32_t>(header, mod.RequiredVersion);
+        header.resize(PackageHeaderSize);
+
+        for (size_t i = 0; i < entries.size(); i++) {
+            const auto& entry = entries[i];
+            WriteValue<uint32_t>(header, nameOffsets[i * 2]);
+            WriteValue<uint32_t>(header, entry.ResourceName.size());
+            WriteValue<uint32_t>(header, nameOffsets[i * 2 + 1]);
+            WriteValue<uint32_t>(header, entry.Name.size());
+            WriteValue<uint64_t>(header, entry.DataOffset);
+            WriteValue<uint64_t>(header, entry.DataSize);
+            WriteValue<uint64_t>(header, entry.TextureOffset);
+            WriteValue<uint64_t>(header, entry.TextureSize);
+            WriteValue<uint32_t>(header, entry.Flags);
+            header.resize(PackageHeaderSize + (i + 1) * PackageEntrySize);
+        }
+
+        header.insert(header.end(), strings.begin(), strings.end());
+
+        failed = fseek(packageFile, 0, SEEK_SET) != 0 || fwrite(header.data(), 1, header.size(), packageFile) != header.size();
+    }
+
+    failed = fclose(packageFile) != 0 || failed;
+
+    std::error_code ec;
+
+    if (!failed) {
+        fs::rename(tempPackagePath, packagePath, ec);
+        failed = static_cast<bool>(ec);
+    }
+
+    if (failed) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to write " << packagePath << '\n';
+        fs::remove(tempPackagePath, ec);
+        return false;
+    }
+
+    os << "Packed " << Colors::Blue << entries.size() << " file(s) " << Colors::Reset << "from " << Colors::Yellow << zippedMod
+        << Colors::Reset << " into " << Colors::Yellow << packagePath << Colors::Reset << '\n';
+    return true;
+}
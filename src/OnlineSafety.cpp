@@ -138,20 +138,23 @@ static const std::vector<std::string> UnsafeResourceNameKeywords = {
     "gameresources", "pvp", "shell", "warehouse"
 };
 
+// Battlemode menu replaced by the multiplayer disabler
+static const std::string MultiplayerDisablerSwfName = "swf/hud/menus/battle_arena/play_online_screen.swf";
+
 std::vector<ResourceModFile> GetMultiplayerDisablerMods()
 {
     // Get multiplayer disabler mods
-    Mod parentMod;
-    parentMod.LoadPriority = INT_MIN;
+    auto parentMod = std::make_shared<Mod>();
+    parentMod->LoadPriority = INT_MIN;
 
     std::vector<ResourceModFile> multiplayerDisablerMods;
     multiplayerDisablerMods.reserve(1 + Languages.size());
 
     // Battlemode
-    ResourceModFile multiplayerDisablerSwf(parentMod, "swf/hud/menus/battle_arena/play_online_screen.swf", "gameresources_patch2", false);
+    ResourceModFile multiplayerDisablerSwf(parentMod, MultiplayerDisablerSwfName, "gameresources_patch2", false);
     multiplayerDisablerSwf.FileBytes = std::vector<std::byte>(reinterpret_cast<const std::byte*>(SWFData),
         reinterpret_cast<const std::byte*>(SWFData) + sizeof(SWFData));
-    multiplayerDisablerMods.push_back(multiplayerDisablerSwf);
+    multiplayerDisablerMods.push_back(std::move(multiplayerDisablerSwf));
 
     // Localization for "Public Match" menu label and "Private Match" menu description
     for (auto& language : Languages) {
@@ -173,15 +176,62 @@ std::vector<ResourceModFile> GetMultiplayerDisablerMods()
 
         multiplayerDisablerBlang.FileBytes = std::vector<std::byte>(reinterpret_cast<const std::byte*>(blangJson.c_str()),
             reinterpret_cast<const std::byte*>(blangJson.c_str()) + blangJson.length());
-        multiplayerDisablerMods.push_back(multiplayerDisablerBlang);
+        multiplayerDisablerMods.push_back(std::move(multiplayerDisablerBlang));
     }
 
     return multiplayerDisablerMods;
 }
 
-bool IsModSafeForOnline(const std::map<size_t, std::vector<ResourceModFile>>& resourceModFiles)
+bool IsMultiplayerDisablerFile(const std::string& modFileName)
+{
+    return modFileName == MultiplayerDisablerSwfName;
+}
+
+bool IsUnsafeResourceName(const std::string& resourceName)
+{
+    std::string lowercaseResourceName = ToLower(resourceName);
+
+    for (const auto& keyword : UnsafeResourceNameKeywords) {
+        if (StartsWith(lowercaseResourceName, keyword)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool IsModFileSafeForUnsafeResource(const std::string& modFileName)
+{
+    std::string lowercaseModFileName = ToLower(modFileName);
+
+    // Skip accidentally included OS files
+    if (EndsWith(lowercaseModFileName, "desktop.ini") || EndsWith(lowercaseModFileName, ".ds_store")) {
+        return true;
+    }
+
+    // Files with .lwo extension are unsafe
+    if (modFileName.find(".lwo") != std::string::npos) {
+        return false;
+    }
+
+    // Allow modification of anything outside of "generated/decls/", except .entities files
+    if (!StartsWith(lowercaseModFileName, "generated/decls/") && !EndsWith(lowercaseModFileName, ".entities")) {
+        return true;
+    }
+
+    // Check if mod file is on whitelist
+    for (const auto& keyword : OnlineSafeModNameKeywords) {
+        if (lowercaseModFileName.find(keyword) != std::string::npos) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool IsModSafeForOnline(const std::map<ResourceContainer*, std::vector<ResourceModFile>>& resourceModFiles)
 {
-    std::vector<ResourceModFile> assetsInfoJsons;
+    std::vector<const ResourceModFile*> assetsInfoJsons;
 
     for (const auto& resource : resourceModFiles) {
         // Skip resources with no mods
@@ -191,50 +241,18 @@ bool IsModSafeForOnline(const std::map<size_t, std::vector<ResourceModFile>>& re
         }
 
         // Check if current resource is unsafe for modifications
-        bool isUnsafeResource = false;
-
-        for (const auto& keyword : UnsafeResourceNameKeywords) {
-            if (StartsWith(ToLower(resource.second[0].ResourceName), keyword)) {
-                isUnsafeResource = true;
-                break;
-            }
-        }
+        bool isUnsafeResource = IsUnsafeResourceName(resource.second[0].ResourceName);
 
         // Iterate through mod files to check safety
         for (const auto& modFile : resource.second) {
-            // Skip accidentally included OS files
-            if (EndsWith(ToLower(modFile.Name), "desktop.ini") || EndsWith(ToLower(modFile.Name), ".ds_store")) {
-                continue;
-            }
-
             // Check assets info files last
             if (modFile.IsAssetsInfoJson) {
-                assetsInfoJsons.push_back(modFile);
+                assetsInfoJsons.push_back(&modFile);
                 continue;
             }
 
-            // Files with .lwo extension are unsafe
-            if (fs::path(modFile.Name).string().find(".lwo") != std::string::npos && isUnsafeResource) {
-                return false;
-            }
-
-            // Allow modification of anything outside of "generated/decls/", except .entities files
-            if (!StartsWith(ToLower(modFile.Name), "generated/decls/") && !EndsWith(ToLower(modFile.Name), ".entities")) {
-                continue;
-            }
-
-            // Check if mod file is on whitelist
-            bool found = false;
-
-            for (const auto& keyword : OnlineSafeModNameKeywords) {
-                if (ToLower(modFile.Name).find(keyword) != std::string::npos) {
-                    found = true;
-                    break;
-                }
-            }
-
             // Do not allow mods to modify non-whitelisted files in unsafe resources
-            if (!found && isUnsafeResource) {
+            if (isUnsafeResource && !IsModFileSafeForUnsafeResource(modFile.Name)) {
                 return false;
             }
         }
@@ -243,13 +261,9 @@ bool IsModSafeForOnline(const std::map<size_t, std::vector<ResourceModFile>>& re
     // Don't allow adding unsafe mods in safe resource files into unsafe resources files
     // Otherwise, don't mark the mod as unsafe, it should be fine for single-player if
     // the mod is not modifying a critical resource
-    for (const auto& assetsInfo : assetsInfoJsons) {
-        if (assetsInfo.AssetsInfo.has_value()) {
-            for (const auto& keyword : UnsafeResourceNameKeywords) {
-                if (StartsWith(ToLower(assetsInfo.ResourceName), keyword)) {
-                    return false;
-                }
-            }
+    for (const auto *assetsInfo : assetsInfoJsons) {
+        if (assetsInfo->AssetsInfo.has_value() && IsUnsafeResourceName(assetsInfo->ResourceName)) {
+            return false;
         }
     }
 
@@ -34,14 +34,19 @@ std::vector<std::byte> Oodle::Decompress(std::vector<std::byte>& compressedData,
 }
 
 std::vector<std::byte> Oodle::Compress(std::vector<std::byte>& decompressedData)
+{
+    return Compress(decompressedData.data(), decompressedData.size());
+}
+
+std::vector<std::byte> Oodle::Compress(const std::byte *decompressedData, const size_t decompressedSize)
 {
     // Get compressed buffer using formula to get size
-    unsigned int compressedBufferSize = decompressedData.size() + 274 * ((decompressedData.size() + 0x3FFFF) / 0x40000);
+    unsigned int compressedBufferSize = decompressedSize + 274 * ((decompressedSize + 0x3FFFF) / 0x40000);
     std::vector<std::byte> compressedData(compressedBufferSize);
 
     // Compress data with oodle
-    int compressedSize = Kraken_Compress(reinterpret_cast<uint8_t*>(decompressedData.data()),
-        decompressedData.size(), reinterpret_cast<uint8_t*>(compressedData.data()), 4);
+    int compressedSize = Kraken_Compress(reinterpret_cast<uint8_t*>(const_cast<std::byte*>(decompressedData)),
+        decompressedSize, reinterpret_cast<uint8_t*>(compressedData.data()), 4);
 
     if (compressedSize <= 0) {
         compressedData.resize(0);
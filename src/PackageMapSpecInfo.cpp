@@ -71,7 +71,7 @@ bool PackageMapSpecInfo::ModifyPackageMapSpec(const std::string& basePath, const
     if (x != streamDBContainerList.end()) {
         // Get custom streamdb
         size_t streamDBContainerIndex = std::distance(streamDBContainerList.begin(), x);
-        auto streamDBContainer = streamDBContainerList[streamDBContainerIndex];
+        const auto& streamDBContainer = streamDBContainerList[streamDBContainerIndex];
 
         if (!streamDBContainer.StreamDBEntries.empty()) {
             if (PackageMapSpec == nullptr && !InvalidPackageMapSpec) {
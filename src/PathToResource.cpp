@@ -16,9 +16,13 @@
 * along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <cstdio>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 #include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
 #include "ProgramOptions.hpp"
 #include "Utils.hpp"
 #include "PathToResource.hpp"
@@ -27,55 +31,304 @@ namespace fs = std::filesystem;
 
 std::vector<fs::path> ResourceContainerPathList;
 
+// Container paths found at startup, so lookups don't need to hit the filesystem
+// Paths under game/ are relative to it, with '/' separators
+static std::unordered_set<std::string> GameResourcePaths;
+static std::unordered_set<std::string> BaseResourceNames;
+static std::unordered_map<std::string, std::string> ResourcePathsByName;
+static std::unordered_set<std::string> SoundContainerNames;
+
+// Normalize a path for the indexes, matching the filesystem's case sensitivity
+static std::string GetPathKey(std::string path)
+{
+    std::replace(path.begin(), path.end(), '\\', '/');
+#ifdef _WIN32
+    path = ToLower(path);
+#endif
+    return path;
+}
+
+// Container catalog cached between runs, so the game directory doesn't have to be walked every time
+// Stores the .resources files under game/ and the directories walked with their modification times
+const char CatalogMagic[8] = { 'E', 'M', 'L', 'C', 'A', 'T', 'L', 'G' };
+const uint32_t CatalogVersion = 1;
+
+class CatalogFile
+{
+public:
+    std::string RelativePath;
+    bool IsRegularFile{false};
+};
+
+class CatalogDirectory
+{
+public:
+    std::string RelativePath;
+    int64_t LastWriteTime{0};
+};
+
+static std::string GetCatalogPath()
+{
+    return ProgramOptions::BasePath + "EternalModLoader.catalog";
+}
+
+static int64_t GetLastWriteTime(const std::string& path)
+{
+    std::error_code errorCode;
+    auto lastWriteTime = fs::last_write_time(path, errorCode);
+    return errorCode ? -1 : static_cast<int64_t>(lastWriteTime.time_since_epoch().count());
+}
+
+static bool ReadCatalogString(FILE *catalogFile, std::string& str)
+{
+    uint32_t length;
+
+    if (fread(&length, 1, 4, catalogFile) != 4 || length > 0xFFFF) {
+        return false;
+    }
+
+    str.resize(length);
+    return fread(str.data(), 1, length, catalogFile) == length;
+}
+
+static void WriteCatalogString(FILE *catalogFile, const std::string& str)
+{
+    uint32_t length = str.size();
+    fwrite(&length, 1, 4, catalogFile);
+    fwrite(str.data(), 1, length, catalogFile);
+}
+
+// Read the cached catalog, failing if any walked directory changed since it was written
+static bool ReadContainerCatalog(const std::string& gamePath, std::vector<CatalogFile>& files)
+{
+    FILE *catalogFile = fopen(GetCatalogPath().c_str(), "rb");
+
+    if (!catalogFile) {
+        return false;
+    }
+
+    bool isValid = true;
+    char magic[8];
+    uint32_t version, count;
+
+    if (fread(magic, 1, 8, catalogFile) != 8 || std::memcmp(magic, CatalogMagic, 8) != 0
+    || fread(&version, 1, 4, catalogFile) != 4 || version != CatalogVersion
+    || fread(&count, 1, 4, catalogFile) != 4) {
+        isValid = false;
+    }
+
+    // Check the directories first, so a stale catalog is rejected before reading the files
+    for (uint32_t i = 0; isValid && i < count; i++) {
+        CatalogDirectory directory;
+
+        if (!ReadCatalogString(catalogFile, directory.RelativePath) || fread(&directory.LastWriteTime, 1, 8, catalogFile) != 8
+        || GetLastWriteTime(gamePath + directory.RelativePath) != directory.LastWriteTime) {
+            isValid = false;
+        }
+    }
+
+    if (isValid && fread(&count, 1, 4, catalogFile) != 4) {
+        isValid = false;
+    }
+
+    for (uint32_t i = 0; isValid && i < count; i++) {
+        CatalogFile file;
+        uint8_t isRegularFile;
+
+        if (!ReadCatalogString(catalogFile, file.RelativePath) || fread(&isRegularFile, 1, 1, catalogFile) != 1) {
+            isValid = false;
+            break;
+        }
+
+        file.IsRegularFile = isRegularFile != 0;
+        files.push_back(file);
+    }
+
+    fclose(catalogFile);
+
+    if (!isValid) {
+        files.clear();
+    }
+
+    return isValid;
+}
+
+// Write the catalog, it's only a cache so failures are ignored
+static void WriteContainerCatalog(const std::vector<CatalogDirectory>& directories, const std::vector<CatalogFile>& files)
+{
+    // Write to a temporary file first, so an interrupted write can't leave a truncated catalog behind
+    std::string catalogPath = GetCatalogPath();
+    std::string tempCatalogPath = catalogPath + ".tmp";
+    FILE *catalogFile = fopen(tempCatalogPath.c_str(), "wb");
+
+    if (!catalogFile) {
+        return;
+    }
+
+    fwrite(CatalogMagic, 1, 8, catalogFile);
+    fwrite(&CatalogVersion, 1, 4, catalogFile);
+
+    uint32_t count = directories.size();
+    fwrite(&count, 1, 4, catalogFile);
+
+    for (const auto& directory : directories) {
+        WriteCatalogString(catalogFile, directory.RelativePath);
+        fwrite(&directory.LastWriteTime, 1, 8, catalogFile);
+    }
+
+    count = files.size();
+    fwrite(&count, 1, 4, catalogFile);
+
+    for (const auto& file : files) {
+        WriteCatalogString(catalogFile, file.RelativePath);
+        uint8_t isRegularFile = file.IsRegularFile ? 1 : 0;
+        fwrite(&isRegularFile, 1, 1, catalogFile);
+    }
+
+    bool failed = ferror(catalogFile) != 0;
+    failed |= fclose(catalogFile) != 0;
+
+    std::error_code ec;
+
+    if (!failed) {
+        fs::rename(tempCatalogPath, catalogPath, ec);
+        failed = static_cast<bool>(ec);
+    }
+
+    if (failed) {
+        fs::remove(tempCatalogPath, ec);
+    }
+}
+
 void GetResourceContainerPathList()
 {
-    for (auto& file : fs::recursive_directory_iterator(ProgramOptions::BasePath + "game" + SEPARATOR)) {
-        if (file.path().extension().string() == ".resources") {
-            ResourceContainerPathList.push_back(file.path());
+    std::string gamePath = ProgramOptions::BasePath + "game" + SEPARATOR;
+    std::vector<CatalogFile> files;
+
+    // Walk the game directory only if the cached catalog is missing or stale
+    if (!ReadContainerCatalog(gamePath, files)) {
+        std::vector<CatalogDirectory> directories;
+        directories.push_back(CatalogDirectory{"", GetLastWriteTime(gamePath)});
+
+        for (auto& file : fs::recursive_directory_iterator(gamePath)) {
+            if (file.is_directory()) {
+                std::string relativePath = file.path().string().substr(gamePath.size());
+                directories.push_back(CatalogDirectory{relativePath, GetLastWriteTime(gamePath + relativePath)});
+            }
+            else if (file.path().extension().string() == ".resources") {
+                files.push_back(CatalogFile{file.path().string().substr(gamePath.size()), file.is_regular_file()});
+            }
+        }
+
+        WriteContainerCatalog(directories, files);
+    }
+
+    for (auto& file : files) {
+        fs::path filePath = gamePath + file.RelativePath;
+        ResourceContainerPathList.push_back(filePath);
+
+        // Keep the first match for each name, like the directory walk does
+        ResourcePathsByName.emplace(GetPathKey(filePath.filename().string()), filePath.string());
+
+        if (file.IsRegularFile) {
+            GameResourcePaths.insert(GetPathKey(file.RelativePath));
+        }
+    }
+
+    // base/ and the soundbanks are single directories, so they're cheap to list every time
+    std::error_code errorCode;
+
+    for (auto& file : fs::directory_iterator(ProgramOptions::BasePath, errorCode)) {
+        if (file.path().extension().string() == ".resources" && file.is_regular_file()) {
+            BaseResourceNames.insert(GetPathKey(file.path().filename().string()));
+        }
+    }
+
+    for (auto& file : fs::directory_iterator(ProgramOptions::BasePath + "sound" + SEPARATOR + "soundbanks" + SEPARATOR + "pc", errorCode)) {
+        if (file.path().extension().string() == ".snd" && file.is_regular_file()) {
+            SoundContainerNames.insert(GetPathKey(file.path().stem().string()));
         }
     }
 }
 
 std::string PathToResourceContainer(const std::string& name)
 {
+    // Only .resources files are indexed
+    bool isIndexed = EndsWith(name, ".resources");
+
     // Check resource filename
     if (StartsWith(name, "dlc_hub")) {
         // dlc hub, remove the "dlc_" prefix, build the path and return it
         std::string resourcePath = name.substr(4, name.size() - 4);
+        bool exists = isIndexed ? GameResourcePaths.count(GetPathKey("dlc/hub/" + resourcePath)) != 0
+            : fs::is_regular_file(ProgramOptions::BasePath + "game" + SEPARATOR + "dlc" + SEPARATOR + "hub" + SEPARATOR + resourcePath);
         resourcePath = ProgramOptions::BasePath + "game" + SEPARATOR + "dlc" + SEPARATOR + "hub" + SEPARATOR + resourcePath;
-        return fs::is_regular_file(resourcePath) ? resourcePath : "";
+        return exists ? resourcePath : "";
     }
     else if (StartsWith(name, "hub")) {
         // Regular hub, build the path and return it
         std::string resourcePath = ProgramOptions::BasePath + "game" + SEPARATOR + "hub" + SEPARATOR + name;
-        return fs::is_regular_file(resourcePath) ? resourcePath : "";
+        bool exists = isIndexed ? GameResourcePaths.count(GetPathKey("hub/" + name)) != 0 : fs::is_regular_file(resourcePath);
+        return exists ? resourcePath : "";
     }
     else if (StartsWith(name, "gameresources")
         || StartsWith(name, "warehouse")
         || StartsWith(name, "meta")) {
             // Resource located in /base/, build path and return it
-            return fs::is_regular_file(ProgramOptions::BasePath + name) ? (ProgramOptions::BasePath + name) : "";
+            bool exists = isIndexed ? BaseResourceNames.count(GetPathKey(name)) != 0 : fs::is_regular_file(ProgramOptions::BasePath + name);
+            return exists ? (ProgramOptions::BasePath + name) : "";
     }
 
     // Find resource iterating through directories
     std::string searchPath = ProgramOptions::BasePath + "game" + SEPARATOR;
 
-    if (fs::is_regular_file(searchPath + name)) {
-        return searchPath + name;
-    }
+    if (!isIndexed) {
+        if (fs::is_regular_file(searchPath + name)) {
+            return searchPath + name;
+        }
 
-    for (auto& file : ResourceContainerPathList) {
-        if (file.filename().string() == name) {
-            return file.string();
+        for (auto& file : ResourceContainerPathList) {
+            if (file.filename().string() == name) {
+                return file.string();
+            }
         }
+
+        return "";
+    }
+
+    if (GameResourcePaths.count(GetPathKey(name)) != 0) {
+        return searchPath + name;
     }
 
-    return "";
+    auto resourcePath = ResourcePathsByName.find(GetPathKey(name));
+    return resourcePath != ResourcePathsByName.end() ? resourcePath->second : "";
 }
 
 std::string PathToSoundContainer(const std::string& name)
 {
     // Assemble snd path and return it
     std::string sndPath = ProgramOptions::BasePath + "sound" + SEPARATOR + "soundbanks" + SEPARATOR + "pc" + SEPARATOR + name + ".snd";
-    return fs::is_regular_file(sndPath) ? sndPath : "";
+    return SoundContainerNames.count(GetPathKey(name)) != 0 ? sndPath : "";
+}
+
+std::vector<std::string> GetAllResourceContainerPaths()
+{
+    std::vector<std::string> containerPaths;
+    std::error_code errorCode;
+
+    for (auto& file : fs::directory_iterator(ProgramOptions::BasePath, errorCode)) {
+        if (file.path().extension().string() == ".resources" && file.is_regular_file()) {
+            containerPaths.push_back(file.path().string());
+        }
+    }
+
+    std::sort(containerPaths.begin(), containerPaths.end());
+
+    for (auto& file : ResourceContainerPathList) {
+        if (fs::is_regular_file(file, errorCode)) {
+            containerPaths.push_back(file.string());
+        }
+    }
+
+    return containerPaths;
 }
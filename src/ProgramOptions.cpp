@@ -19,6 +19,7 @@
 #include <iostream>
 #include <filesystem>
 #include <sstream>
+#include <cstdint>
 #include <cstring>
 #include "Colors.hpp"
 #include "ProgramOptions.hpp"
@@ -64,6 +65,76 @@ std::stringstream ProgramOptions::GetProgramOptions(char **arguments, int count)
                 MultiThreading = false;
                 output << Colors::Yellow << "INFO: Multi-threading is disabled." << Colors::Reset << '\n';
             }
+            else if (!strcmp(arguments[i], "--jobs") && count > i + 1) {
+                std::string jobs = arguments[++i];
+
+                try {
+                    if (jobs.find_first_not_of("0123456789") != std::string::npos) {
+                        throw std::exception();
+                    }
+
+                    Jobs = std::stoul(jobs);
+
+                    if (Jobs == 0) {
+                        throw std::exception();
+                    }
+
+                    output << Colors::Yellow << "INFO: Using " << Jobs << " worker thread(s)." << Colors::Reset << '\n';
+                }
+                catch (...) {
+                    Jobs = 0;
+                    output << Colors::Red << "WARNING: " << Colors::Reset << "Invalid job count: " << jobs << '\n';
+                }
+            }
+            else if (!strcmp(arguments[i], "--max-memory") && count > i + 1) {
+                std::string maxMemory = arguments[++i];
+
+                try {
+                    if (maxMemory.find_first_not_of("0123456789") != std::string::npos) {
+                        throw std::exception();
+                    }
+
+                    // The limit is given in MB, reject it if it doesn't fit in bytes
+                    unsigned long long maxMemoryMB = std::stoull(maxMemory);
+
+                    if (maxMemoryMB > SIZE_MAX / (1024 * 1024)) {
+                        throw std::exception();
+                    }
+
+                    MaxMemory = static_cast<size_t>(maxMemoryMB) * 1024 * 1024;
+
+                    if (MaxMemory == 0) {
+                        throw std::exception();
+                    }
+
+                    output << Colors::Yellow << "INFO: Limiting mod data in memory to " << maxMemory << " MB." << Colors::Reset << '\n';
+                }
+                catch (...) {
+                    MaxMemory = 0;
+                    output << Colors::Red << "WARNING: " << Colors::Reset << "Invalid memory limit: " << maxMemory << '\n';
+                }
+            }
+            else if (!strcmp(arguments[i], "--pack")) {
+                PackMods = true;
+                output << Colors::Yellow << "INFO: Zipped mods will be converted to .emlpack packages." << Colors::Reset << '\n';
+            }
+            else if (!strcmp(arguments[i], "--repack")) {
+                RepackContainers = true;
+
+                // The containers to repack are optional, all of them are repacked by default
+                if (count > i + 1 && strncmp(arguments[i + 1], "--", 2) != 0) {
+                    std::stringstream containerNames(arguments[++i]);
+                    std::string containerName;
+
+                    while (std::getline(containerNames, containerName, ',')) {
+                        if (!containerName.empty()) {
+                            RepackContainerNames.push_back(containerName);
+                        }
+                    }
+                }
+
+                output << Colors::Yellow << "INFO: " << (RepackContainerNames.empty() ? "All" : "The selected") << " resource containers will be repacked." << Colors::Reset << '\n';
+            }
             else if (!strcmp(arguments[i], "--redirectBlangContainer") && count > i + 1) {
                 BlangFileContainerRedirect = arguments[++i];
                 output << Colors::Yellow << "INFO: BLang file modifications will be redirected to container " <<  BlangFileContainerRedirect << " (if it exists)." << Colors::Reset << '\n';
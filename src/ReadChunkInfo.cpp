@@ -16,45 +16,79 @@
 * along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cstring>
 #include "ReadChunkInfo.hpp"
 
-void ReadChunkInfo(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer)
+// Containers with fewer chunks than this are read on a single thread
+static constexpr size_t ParallelChunkCount = 1 << 16;
+
+// Read the chunks in [begin, end) into the table
+static void ReadChunkRange(const MemoryMappedFile& memoryMappedFile, const ResourceContainer& resourceContainer,
+    ChunkTable& chunks, const size_t begin, const size_t end)
 {
-    size_t dummy7Off = resourceContainer.Dummy7Offset + (resourceContainer.TypeCount * 4);
+    size_t nameIdsOffset = resourceContainer.Dummy7Offset + (resourceContainer.TypeCount * 4);
+    const std::byte *records = memoryMappedFile.Mem + resourceContainer.InfoOffset;
+    ResourceFileInfo record;
 
-    uint64_t nameId, fileOffset, sizeOffset, sizeZ, size;
-    std::byte compressionMode;
-    ResourceName name;
+    for (size_t i = begin; i < end; i++) {
+        // Records aren't necessarily aligned in the container
+        std::memcpy(&record, records + sizeof(ResourceFileInfo) * i, sizeof(ResourceFileInfo));
 
-    // Iterate through files to get all chunks
-    for (int i = 0; i < resourceContainer.FileCount; i++) {
-        std::copy(memoryMappedFile.Mem + 0x20 + resourceContainer.InfoOffset + (0x90 * i),
-            memoryMappedFile.Mem + 0x20 + resourceContainer.InfoOffset + (0x90 * i) + 8, reinterpret_cast<std::byte*>(&nameId));
+        uint64_t nameId;
+        std::memcpy(&nameId, memoryMappedFile.Mem + nameIdsOffset + (record.NameIdIndex + 1) * 8, 8);
 
-        std::copy(memoryMappedFile.Mem + 0x38 + resourceContainer.InfoOffset + (0x90 * i),
-            memoryMappedFile.Mem + 0x38 + resourceContainer.InfoOffset + (0x90 * i) + 8, reinterpret_cast<std::byte*>(&fileOffset));
+        chunks.FileOffsets[i] = GetChunkFileOffset(resourceContainer.InfoOffset, i);
+        chunks.SizesZ[i] = record.SizeZ;
+        chunks.Sizes[i] = record.Size;
+        chunks.CompressionModes[i] = record.CompressionMode;
+        chunks.NameIds[i] = nameId;
+    }
+}
 
-        sizeOffset = 0x38 + resourceContainer.InfoOffset + (0x90 * i) + 8;
+void ReadChunkInfo(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer, ThreadPool *threadPool)
+{
+    ChunkTable& chunks = resourceContainer.Chunks;
+    size_t chunkCount = resourceContainer.FileCount;
+    chunks.resize(chunkCount);
 
-        std::copy(memoryMappedFile.Mem + 0x38 + resourceContainer.InfoOffset + (0x90 * i) + 8,
-            memoryMappedFile.Mem + 0x38 + resourceContainer.InfoOffset + (0x90 * i) + 16, reinterpret_cast<std::byte*>(&sizeZ));
+    // Split very large containers between the pool's workers
+    size_t rangeCount = 1;
 
-        std::copy(memoryMappedFile.Mem + 0x38 + resourceContainer.InfoOffset + (0x90 * i) + 16,
-            memoryMappedFile.Mem + 0x38 + resourceContainer.InfoOffset + (0x90 * i) + 24, reinterpret_cast<std::byte*>(&size));
+    if (threadPool != nullptr && chunkCount >= ParallelChunkCount * 2) {
+        rangeCount = std::min(threadPool->ThreadCount(), chunkCount / ParallelChunkCount);
+    }
 
-        compressionMode = memoryMappedFile.Mem[0x70 + resourceContainer.InfoOffset + 0x90 * i];
+    if (rangeCount <= 1) {
+        ReadChunkRange(memoryMappedFile, resourceContainer, chunks, 0, chunkCount);
+    }
+    else {
+        TaskGroup rangeTasks;
+        size_t rangeSize = (chunkCount + rangeCount - 1) / rangeCount;
+
+        for (size_t begin = rangeSize; begin < chunkCount; begin += rangeSize) {
+            threadPool->Submit([&, begin] {
+                ReadChunkRange(memoryMappedFile, resourceContainer, chunks, begin, std::min(begin + rangeSize, chunkCount));
+            }, &rangeTasks);
+        }
+
+        ReadChunkRange(memoryMappedFile, resourceContainer, chunks, 0, rangeSize);
+        threadPool->Wait(rangeTasks);
+    }
 
-        nameId = ((nameId + 1) * 8) + dummy7Off;
-        std::copy(memoryMappedFile.Mem + nameId, memoryMappedFile.Mem + nameId + 8, reinterpret_cast<std::byte*>(&nameId));
+    // Index the chunks by their full and normalized names
+    // Only the first chunk with a name is kept, matching the order of a linear search
+    resourceContainer.ChunkIndex.clear();
+    resourceContainer.ChunkIndex.reserve(chunks.size());
 
-        name = resourceContainer.NamesList[nameId];
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const ResourceName& name = resourceContainer.GetChunkName(i);
+        std::string_view normalizedName = name.NormalizedFileName();
+        resourceContainer.ChunkIndex.emplace(name.FullFileName, i);
 
-        ResourceChunk chunk(name, fileOffset);
-        chunk.FileOffset = sizeOffset - 8;
-        chunk.SizeOffset = sizeOffset;
-        chunk.SizeZ = sizeZ;
-        chunk.Size = size;
-        chunk.CompressionMode = compressionMode;
-        resourceContainer.ChunkList.push_back(chunk);
+        // The normalized name is part of the full name, so it's only different if it's shorter
+        if (normalizedName.size() != name.FullFileName.size()) {
+            resourceContainer.ChunkIndex.emplace(normalizedName, i);
+        }
     }
 }
@@ -16,11 +16,13 @@
 * along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cstring>
 #include "ReadChunkInfo.hpp"
 #include "Utils.hpp"
 #include "ReadResourceFile.hpp"
 
-void ReadResource(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer)
+void ReadResource(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer, ThreadPool *threadPool)
 {
     unsigned int fileCount;
     std::copy(memoryMappedFile.Mem + 0x20, memoryMappedFile.Mem + 0x24, reinterpret_cast<std::byte*>(&fileCount));
@@ -59,30 +61,25 @@ void ReadResource(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourc
     size_t namesOffsetEnd = namesOffset + (namesNum + 1) * 8;
     size_t namesSize = namesEnd - namesOffsetEnd;
 
-    std::vector<ResourceName> namesList;
-    std::vector<char> currentNameBytes;
-    char currentByte;
-
-    for (size_t i = 0; i < namesSize; i++) {
-        if (namesList.size() == namesNum) {
-            break;
-        }
+    // Copy the names section once, the mapping moves whenever the container is resized
+    auto namesCopy = std::make_unique<char[]>(namesSize);
+    std::copy(memoryMappedFile.Mem + namesOffsetEnd, memoryMappedFile.Mem + namesOffsetEnd + namesSize, reinterpret_cast<std::byte*>(namesCopy.get()));
+    resourceContainer.NamesData = std::move(namesCopy);
 
-        currentByte = static_cast<char>(memoryMappedFile.Mem[namesOffsetEnd+ i]);
-
-        if (currentByte == 0 || i == namesSize - 1) {
-            // Support full filenames and "normalized" filenames (backwards compatibility)
-            std::string fullFileName(currentNameBytes.data(), currentNameBytes.size());
-            std::string normalizedFileName = NormalizeResourceFilename(fullFileName);
+    // Split the names at their null terminators, viewing them from the copy
+    const char *namesData = resourceContainer.NamesData.get();
+    std::vector<ResourceName> namesList;
+    namesList.reserve(std::min<uint64_t>(namesNum, namesSize));
+    size_t namePosition = 0;
 
-            ResourceName resourceName(fullFileName, normalizedFileName);
-            namesList.push_back(resourceName);
+    while (namesList.size() < namesNum && namePosition < namesSize) {
+        auto nameEnd = static_cast<const char*>(std::memchr(namesData + namePosition, 0, namesSize - namePosition));
 
-            currentNameBytes.clear();
-            continue;
-        }
+        // An unterminated last name loses its last byte
+        size_t nameLength = nameEnd != nullptr ? nameEnd - (namesData + namePosition) : namesSize - 1 - namePosition;
 
-        currentNameBytes.push_back(currentByte);
+        namesList.emplace_back(std::string_view(namesData + namePosition, nameLength));
+        namePosition += nameLength + 1;
     }
 
     // Assign all values to resource
@@ -99,8 +96,8 @@ void ReadResource(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourc
     resourceContainer.NamesOffsetEnd = namesOffsetEnd;
     resourceContainer.UnknownOffset = namesEnd;
     resourceContainer.UnknownOffset2 = namesEnd;
-    resourceContainer.NamesList = namesList;
+    resourceContainer.NamesList = std::move(namesList);
 
     // Get resource chunks
-    ReadChunkInfo(memoryMappedFile, resourceContainer);
+    ReadChunkInfo(memoryMappedFile, resourceContainer, threadPool);
 }
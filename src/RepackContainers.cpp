@@ -0,0 +1,284 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "Colors.hpp"
+#include "MemoryMappedFile.hpp"
+#include "ProgramOptions.hpp"
+#include "ReadResourceFile.hpp"
+#include "ResourceContainer.hpp"
+#include "RepackContainers.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+extern std::mutex mtx;
+
+// Bytes of data being copied at once by all the containers, unless limited with --max-memory
+static constexpr size_t DefaultRepackBudget = 256 * 1024 * 1024;
+
+// Live data is copied in batches of about this size, each one reserved from the budget while it's written
+static constexpr size_t RepackBatchSize = 8 * 1024 * 1024;
+
+// Chunk data is aligned from the start of the data section, like the data appended by the loader
+static constexpr uint64_t DataAlignment = 0x10;
+
+// Data used by one or more chunks, and where it goes in the repacked container, 0 until it's placed
+class LiveRange
+{
+public:
+    uint64_t Offset;
+    uint64_t Size;
+    uint64_t NewOffset;
+};
+
+int64_t RepackContainer(const std::string& containerPath, MemoryBudget *ioBudget, ThreadPool *threadPool, std::stringstream& os)
+{
+    std::unique_ptr<MemoryMappedFile> containerFile;
+
+    try {
+        containerFile = std::make_unique<MemoryMappedFile>(containerPath, true);
+    }
+    catch (...) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to load " << containerPath << " into memory for repacking" << '\n';
+        return -1;
+    }
+
+    ResourceContainer resourceContainer(fs::path(containerPath).filename().string(), containerPath);
+    uint64_t dataOffset = 0;
+
+    if (containerFile->Size >= 0x7C) {
+        std::memcpy(&dataOffset, containerFile->Mem + 0x68, 8);
+    }
+
+    if (dataOffset == 0 || dataOffset > containerFile->Size) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << containerPath << " is not a valid resource container, not repacking it" << '\n';
+        return -1;
+    }
+
+    ReadResource(*containerFile, resourceContainer, threadPool);
+
+    // Find the data of every chunk, chunks without data point at the start of the data section
+    const ChunkTable& chunks = resourceContainer.Chunks;
+    std::vector<std::pair<uint64_t, size_t>> chunkOffsets;
+    std::vector<uint64_t> newOffsets(chunks.size(), dataOffset);
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        uint64_t offset;
+        std::memcpy(&offset, containerFile->Mem + chunks.FileOffsets[i], 8);
+        uint64_t size = chunks.SizesZ[i];
+
+        if (size == 0) {
+            continue;
+        }
+
+        if (offset < dataOffset || offset > containerFile->Size || size > containerFile->Size - offset) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Data of " << resourceContainer.GetChunkName(i).FullFileName
+                << " is outside of " << containerPath << ", not repacking it" << '\n';
+            return -1;
+        }
+
+        chunkOffsets.emplace_back(offset, i);
+    }
+
+    // Merge the data of chunks that overlap, so chunks sharing any of their data keep sharing it
+    std::sort(chunkOffsets.begin(), chunkOffsets.end());
+    std::vector<LiveRange> liveRanges;
+    std::vector<size_t> chunkRanges(chunks.size(), SIZE_MAX);
+    std::vector<uint64_t> oldOffsets(chunks.size());
+
+    for (const auto& [offset, chunk] : chunkOffsets) {
+        uint64_t end = offset + chunks.SizesZ[chunk];
+
+        if (liveRanges.empty() || offset >= liveRanges.back().Offset + liveRanges.back().Size) {
+            liveRanges.push_back(LiveRange{offset, end - offset, 0});
+        }
+        else {
+            liveRanges.back().Size = std::max(liveRanges.back().Size, end - liveRanges.back().Offset);
+        }
+
+        chunkRanges[chunk] = liveRanges.size() - 1;
+        oldOffsets[chunk] = offset;
+    }
+
+    // Lay out the live data in chunk table order, each range going where the first chunk using it is
+    std::vector<size_t> layout;
+    layout.reserve(liveRanges.size());
+    uint64_t newSize = dataOffset;
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (chunkRanges[i] == SIZE_MAX) {
+            continue;
+        }
+
+        LiveRange& liveRange = liveRanges[chunkRanges[i]];
+
+        // Data only moves by a multiple of the alignment, so the chunks keep their alignment
+        if (liveRange.NewOffset == 0) {
+            newSize += (liveRange.Offset - newSize) % DataAlignment;
+            liveRange.NewOffset = newSize;
+            newSize += liveRange.Size;
+            layout.push_back(chunkRanges[i]);
+        }
+
+        newOffsets[i] = liveRange.NewOffset + oldOffsets[i] - liveRange.Offset;
+    }
+
+    uint64_t oldSize = containerFile->Size;
+
+    if (newSize >= oldSize) {
+        os << containerPath << " is already packed" << '\n';
+        return 0;
+    }
+
+    // Write to a temporary file first, so an interrupted repack can't leave a broken container behind
+    std::string tempContainerPath = containerPath + ".repack";
+    FILE *tempContainerFile = fopen(tempContainerPath.c_str(), "wb");
+
+    if (tempContainerFile == nullptr) {
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to create " << tempContainerPath << '\n';
+        return -1;
+    }
+
+    // Copy the headers and tables, pointing the chunks at their new data
+    std::vector<std::byte> tables(containerFile->Mem, containerFile->Mem + dataOffset);
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        std::memcpy(tables.data() + chunks.FileOffsets[i], &newOffsets[i], 8);
+    }
+
+    bool failed = fwrite(tables.data(), 1, tables.size(), tempContainerFile) != tables.size();
+    tables = std::vector<std::byte>();
+
+    // Copy the live data, the pages read from the old container are released as soon as they're written
+    static const std::byte padding[DataAlignment]{};
+    uint64_t position = dataOffset;
+    size_t batchStart = 0;
+
+    while (batchStart < layout.size() && !failed) {
+        size_t batchEnd = batchStart;
+        size_t batchSize = 0;
+
+        while (batchEnd < layout.size() && batchSize < RepackBatchSize) {
+            batchSize += liveRanges[layout[batchEnd++]].Size;
+        }
+
+        MemoryReservation reservation(ioBudget, batchSize);
+
+        for (size_t i = batchStart; i < batchEnd && !failed; i++) {
+            const LiveRange& liveRange = liveRanges[layout[i]];
+            failed |= fwrite(padding, 1, liveRange.NewOffset - position, tempContainerFile) != liveRange.NewOffset - position;
+            failed |= fwrite(containerFile->Mem + liveRange.Offset, 1, liveRange.Size, tempContainerFile) != liveRange.Size;
+            containerFile->DropPages(liveRange.Offset, liveRange.Size);
+            position = liveRange.NewOffset + liveRange.Size;
+        }
+
+        batchStart = batchEnd;
+    }
+
+    failed |= fflush(tempContainerFile) != 0;
+
+    // Make sure the data is on disk before the old container is replaced
+#ifdef _WIN32
+    failed |= FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(tempContainerFile)))) == 0;
+#else
+    failed |= fsync(fileno(tempContainerFile)) != 0;
+#endif
+
+    failed |= fclose(tempContainerFile) != 0;
+
+    // The container can't be replaced while it's mapped on Windows
+    containerFile.reset();
+    std::error_code ec;
+
+    if (!failed) {
+        fs::permissions(tempContainerPath, fs::status(containerPath, ec).permissions(), ec);
+        fs::rename(tempContainerPath, containerPath, ec);
+        failed = static_cast<bool>(ec);
+    }
+
+    if (failed) {
+        fs::remove(tempContainerPath, ec);
+        os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to repack " << containerPath << '\n';
+        return -1;
+    }
+
+    os << "Repacked " << Colors::Yellow << containerPath << Colors::Reset << ", reclaimed " << oldSize - newSize << " bytes" << '\n';
+    return static_cast<int64_t>(oldSize - newSize);
+}
+
+void RepackContainers(const std::vector<std::string>& containerPaths, ThreadPool *threadPool)
+{
+    // Limit how much data is copied at once across all the containers
+    MemoryBudget ioBudget(ProgramOptions::MaxMemory != 0 ? ProgramOptions::MaxMemory : DefaultRepackBudget);
+    std::atomic<uint64_t> reclaimedBytes{0};
+    std::atomic<size_t> repackedCount{0};
+    std::atomic<size_t> failedCount{0};
+
+    auto repackContainer = [&](const std::string& containerPath) {
+        std::stringstream os;
+        int64_t reclaimed = RepackContainer(containerPath, &ioBudget, threadPool, os);
+
+        if (reclaimed > 0) {
+            reclaimedBytes += reclaimed;
+            repackedCount++;
+        }
+        else if (reclaimed < 0) {
+            failedCount++;
+        }
+
+        mtx.lock();
+        std::cout << os.rdbuf();
+        mtx.unlock();
+    };
+
+    for (const auto& containerPath : containerPaths) {
+        if (threadPool != nullptr) {
+            threadPool->Submit([&, containerPath] { repackContainer(containerPath); });
+        }
+        else {
+            repackContainer(containerPath);
+        }
+    }
+
+    if (threadPool != nullptr) {
+        threadPool->Wait();
+    }
+
+    std::cout << '\n' << "Reclaimed " << Colors::Yellow << reclaimedBytes << " bytes" << Colors::Reset << " from " << repackedCount << " resource container(s).";
+
+    if (failedCount > 0) {
+        std::cout << Colors::Red << " " << failedCount << " container(s) failed to repack." << Colors::Reset;
+    }
+
+    std::cout << '\n';
+}
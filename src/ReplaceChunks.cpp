@@ -40,11 +40,10 @@ namespace fs = std::filesystem;
 extern std::mutex mtx;
 
 void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer,
-    std::map<uint64_t, ResourceDataEntry>& resourceDataMap, std::stringstream& os,
-    std::unique_ptr<std::byte[]>& buffer, int bufferSize)
+    std::map<uint64_t, ResourceDataEntry>& resourceDataMap, ThreadPool *threadPool, std::stringstream& os)
 {
     // For map resources modifications
-    ResourceChunk *mapResourcesChunk = nullptr;
+    ssize_t mapResourcesChunk = -1;
     std::unique_ptr<MapResourcesFile> mapResourcesFile;
     std::vector<std::byte> originalDecompressedMapResources;
     bool invalidMapResources = false;
@@ -53,13 +52,150 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
     // For .blang file modifications
     std::map<std::string, BlangFileEntry> blangFileEntries;
 
+    // Mod data to write into the container
+    ChunkWritePlan writePlan(memoryMappedFile, resourceContainer, threadPool);
+
     // Sort mod file list by priority
     std::stable_sort(resourceContainer.ModFileList.begin(), resourceContainer.ModFileList.end(),
-        [](const ResourceModFile& resource1, const ResourceModFile& resource2) { return resource1.Parent.LoadPriority > resource2.Parent.LoadPriority; });
+        [](const ResourceModFile& resource1, const ResourceModFile& resource2) { return resource1.Parent->LoadPriority > resource2.Parent->LoadPriority; });
+
+    // Resolve which mod files replace each chunk before any data is read:
+    // only the last write in priority order would survive, so only the last one is written,
+    // falling back to the ones it overrides in priority order if its data can't be written
+    std::vector<ssize_t> modFileChunks(resourceContainer.ModFileList.size(), -1);
+    std::map<ssize_t, std::vector<size_t>> chunkCandidates;
+    std::map<ssize_t, size_t> chunkWinners;
+
+    for (size_t i = 0; i < resourceContainer.ModFileList.size(); i++) {
+        const auto& modFile = resourceContainer.ModFileList[i];
+
+        if ((modFile.IsAssetsInfoJson && modFile.AssetsInfo.has_value()) || modFile.IsBlangJson) {
+            continue;
+        }
+
+        modFileChunks[i] = GetChunk(modFile.Name, resourceContainer);
+
+        if (modFileChunks[i] == -1) {
+            continue;
+        }
+
+        // .blang and .mapresources files are read back when merging into them, so every write to them is kept
+        const std::string_view chunkName = resourceContainer.GetChunkName(modFileChunks[i]).NormalizedFileName();
+
+        if (EndsWith(chunkName, ".blang") || EndsWith(chunkName, ".mapresources")) {
+            continue;
+        }
+
+        chunkCandidates[modFileChunks[i]].push_back(i);
+    }
+
+    // Plan replacing a chunk's data with a mod file, returning whether it could be planned
+    auto planModFile = [&](ResourceModFile& modFile, const ssize_t chunk) {
+        uint64_t compressedSize = modFile.FileBytes.size();
+        uint64_t uncompressedSize = compressedSize;
+        std::byte compressionMode{0};
+
+        // If this is a texture, check if it's compressed, or compress it if necessary
+        if ((EndsWith(resourceContainer.GetChunkName(chunk).NormalizedFileName(), ".tga") || EndsWith(resourceContainer.GetChunkName(chunk).NormalizedFileName(), ".png")) && compressedSize != 0) {
+            // Check if it's a DIVINITY compressed texture
+            std::byte divinityHeader[16];
+
+            if (modFile.FileBytes.Peek(divinityHeader, sizeof(divinityHeader)) && std::memcmp(divinityHeader, "DIVINITY", 8) == 0) {
+                // This is a compressed texture, read the uncompressed size
+                std::copy(divinityHeader + 8, divinityHeader + 16, reinterpret_cast<std::byte*>(&uncompressedSize));
+
+                // Set the compressed texture data, skipping the DIVINITY header (16 bytes)
+                modFile.FileBytes.RemovePrefix(16);
+                compressedSize = modFile.FileBytes.size();
+                compressionMode = std::byte{2};
+
+                if (ProgramOptions::Verbose) {
+                    os << "\tSuccessfully set compressed texture data for file " << modFile.Name << '\n';
+                }
+            }
+            else if (ProgramOptions::CompressTextures) {
+                // Compress the texture
+                std::vector<std::byte> compressedData;
+
+                try {
+                    if (!modFile.FileBytes.Load()) {
+                        throw std::exception();
+                    }
+
+                    compressedData = Oodle::Compress(modFile.FileBytes.data(), modFile.FileBytes.size());
+
+                    if (compressedData.empty()) {
+                        throw std::exception();
+                    }
+                }
+                catch (...) {
+                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to compress " << modFile.Name << '\n';
+                    return false;
+                }
+
+                modFile.FileBytes = std::move(compressedData);
+                compressedSize = modFile.FileBytes.size();
+                compressionMode = std::byte{2};
+
+                if (ProgramOptions::Verbose) {
+                    os << "\tSuccessfully compressed texture file " << modFile.Name << '\n';
+                }
+            }
+        }
+
+        if (!SetModDataForChunk(resourceContainer, chunk, modFile,
+        compressedSize, uncompressedSize, &compressionMode, writePlan)) {
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to set new mod data for " << modFile.Name << " in resource chunk." << '\n';
+            return false;
+        }
+
+        if (modFile.Announce) {
+            os << "\tReplaced " << modFile.Name << '\n';
+        }
+
+        fileCount++;
+        return true;
+    };
+
+    // Plan the highest priority mod file left for a chunk, moving on to the next one if it fails
+    auto planNextCandidate = [&](const ssize_t chunk) {
+        auto& candidates = chunkCandidates[chunk];
+
+        while (!candidates.empty()) {
+            size_t candidate = candidates.back();
+            candidates.pop_back();
+
+            if (planModFile(resourceContainer.ModFileList[candidate], chunk)) {
+                chunkWinners[chunk] = candidate;
+                return true;
+            }
+        }
+
+        chunkWinners.erase(chunk);
+        return false;
+    };
+
+    // Write the planned data, planning the next mod file for the chunks whose data failed to be written
+    auto writePlannedData = [&] {
+        bool replanned = true;
+
+        while (replanned) {
+            std::vector<size_t> failedChunks;
+            fileCount -= writePlan.Write(os, failedChunks);
+            replanned = false;
+
+            for (size_t chunk : failedChunks) {
+                if (chunkCandidates.count(chunk) != 0 && planNextCandidate(chunk)) {
+                    replanned = true;
+                }
+            }
+        }
+    };
 
     // Load mod files now
-    for (auto& modFile : resourceContainer.ModFileList) {
-        ResourceChunk *chunk = nullptr;
+    for (size_t i = 0; i < resourceContainer.ModFileList.size(); i++) {
+        auto& modFile = resourceContainer.ModFileList[i];
+        ssize_t chunk = -1;
 
         // Handle AssetsInfo JSON files
         if (modFile.IsAssetsInfoJson && modFile.AssetsInfo.has_value()) {
@@ -241,25 +377,28 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
             // First, find, read and deserialize the .mapresources file in this container
             // If this is a "gameresources" container, only search for "common.mapresources"
             if (mapResourcesFile == nullptr && !invalidMapResources) {
-                for (auto& file : resourceContainer.ChunkList) {
-                    if (EndsWith(file.ResourceName.NormalizedFileName, ".mapresources")) {
-                        if (StartsWith(resourceContainer.Name, "gameresources") && EndsWith(file.ResourceName.NormalizedFileName, "init.mapresources")) {
+                // The planned data must be in the container before any is read back
+                writePlannedData();
+
+                for (size_t file = 0; file < resourceContainer.Chunks.size(); file++) {
+                    if (EndsWith(resourceContainer.GetChunkName(file).NormalizedFileName(), ".mapresources")) {
+                        if (StartsWith(resourceContainer.Name, "gameresources") && EndsWith(resourceContainer.GetChunkName(file).NormalizedFileName(), "init.mapresources")) {
                             continue;
                         }
 
-                        mapResourcesChunk = &file;
+                        mapResourcesChunk = file;
 
                         // Read the mapresources file data (it should be compressed)
-                        std::vector<std::byte> mapResourcesBytes(mapResourcesChunk->SizeZ);
+                        std::vector<std::byte> mapResourcesBytes(resourceContainer.Chunks.SizesZ[mapResourcesChunk]);
                         uint64_t mapResourcesFileOffset;
 
-                        std::copy(memoryMappedFile.Mem + mapResourcesChunk->FileOffset,
-                            memoryMappedFile.Mem + mapResourcesChunk->FileOffset + 8, reinterpret_cast<std::byte*>(&mapResourcesFileOffset));
+                        std::copy(memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[mapResourcesChunk],
+                            memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[mapResourcesChunk] + 8, reinterpret_cast<std::byte*>(&mapResourcesFileOffset));
                         std::copy(memoryMappedFile.Mem + mapResourcesFileOffset, memoryMappedFile.Mem + mapResourcesFileOffset + mapResourcesBytes.size(), mapResourcesBytes.begin());
 
                         // Decompress the data
                         try {
-                            originalDecompressedMapResources = Oodle::Decompress(mapResourcesBytes, mapResourcesChunk->Size);
+                            originalDecompressedMapResources = Oodle::Decompress(mapResourcesBytes, resourceContainer.Chunks.Sizes[mapResourcesChunk]);
 
                             if (originalDecompressedMapResources.empty()) {
                                 throw std::exception();
@@ -270,7 +409,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                         }
                         catch (...) {
                             invalidMapResources = true;
-                            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to decompress " << mapResourcesChunk->ResourceName.NormalizedFileName
+                            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to decompress " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName()
                                 << " - are you trying to add assets in the wrong .resources archive?" << '\n';
                             break;
                         }
@@ -280,7 +419,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
 
             // Don't add anything if the file was not found or couldn't be decompressed
             if (mapResourcesFile == nullptr || invalidMapResources) {
-                modFile.FileBytes.resize(0);
+                modFile.FileBytes.clear();
                 continue;
             }
 
@@ -290,14 +429,14 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                     if (std::find(mapResourcesFile->Layers.begin(), mapResourcesFile->Layers.end(), newLayers.Name) != mapResourcesFile->Layers.end()) {
                         if (ProgramOptions::Verbose) {
                             os << Colors::Red << "ERROR: " << Colors::Reset << "Trying to add layer " << newLayers.Name << " that has already been added in "
-                                << mapResourcesChunk->ResourceName.NormalizedFileName << ", skipping" << '\n';
+                                << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << ", skipping" << '\n';
                         }
 
                         continue;
                     }
 
                     mapResourcesFile->Layers.push_back(newLayers.Name);
-                    os << "\tAdded layer " << newLayers.Name << " to " << mapResourcesChunk->ResourceName.NormalizedFileName
+                    os << "\tAdded layer " << newLayers.Name << " to " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName()
                         << " in " << resourceContainer.Name << "" << '\n';
                 }
             }
@@ -308,14 +447,14 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                     if (std::find(mapResourcesFile->Maps.begin(), mapResourcesFile->Maps.end(), newMaps.Name) != mapResourcesFile->Maps.end()) {
                         if (ProgramOptions::Verbose) {
                             os << Colors::Red << "ERROR: " << Colors::Reset << "Trying to add map " << newMaps.Name <<" that has already been added in "
-                                << mapResourcesChunk->ResourceName.NormalizedFileName << ", skipping" << '\n';
+                                << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << ", skipping" << '\n';
                         }
 
                         continue;
                     }
 
                     mapResourcesFile->Maps.push_back(newMaps.Name);
-                    os << "Added map " << newMaps.Name << " to " << mapResourcesChunk->ResourceName.NormalizedFileName << " in " << resourceContainer.Name << '\n';
+                    os << "Added map " << newMaps.Name << " to " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in " << resourceContainer.Name << '\n';
                 }
             }
 
@@ -337,7 +476,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                         if (x == mapResourcesFile->AssetTypes.end()) {
                             if (ProgramOptions::Verbose) {
                                 os << Colors::Red << "WARNING: " << Colors::Reset << "Can't remove asset " << newAsset.Name << " with type " << newAsset.MapResourceType <<
-                                    " because it doesn't exist in " << mapResourcesChunk->ResourceName.NormalizedFileName << '\n';
+                                    " because it doesn't exist in " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << '\n';
                                 continue;
                             }
                         }
@@ -356,11 +495,11 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
 
                         if (assetFound) {
                             os << "\tRemoved asset " << newAsset.Name << " with type " << newAsset.MapResourceType <<
-                                " from " << mapResourcesChunk->ResourceName.NormalizedFileName << " in " << resourceContainer.Name << '\n';
+                                " from " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in " << resourceContainer.Name << '\n';
                         }
                         else {
                             os << Colors::Red << "WARNING: " << Colors::Reset << "Can't remove asset " << newAsset.Name << " with type " << newAsset.MapResourceType <<
-                                " because it doesn't exist in " << mapResourcesChunk->ResourceName.NormalizedFileName << '\n';
+                                " because it doesn't exist in " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << '\n';
                         }
 
                         continue;
@@ -379,7 +518,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                     if (alreadyExists) {
                         if (ProgramOptions::Verbose) {
                             os << Colors::Red << "WARNING: " << Colors::Reset << "Failed to add asset " << newAsset.Name <<
-                                " that has already been added in " << mapResourcesChunk->ResourceName.NormalizedFileName << ", skipping" << '\n';
+                                " that has already been added in " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << ", skipping" << '\n';
                         }
 
                         continue;
@@ -401,7 +540,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                         assetTypeIndex = mapResourcesFile->AssetTypes.size() - 1;
 
                         os << "Added asset type " << newAsset.MapResourceType << " to " <<
-                            mapResourcesChunk->ResourceName.NormalizedFileName << " in " << resourceContainer.Name << '\n';
+                            resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in " << resourceContainer.Name << '\n';
                     }
 
                      // Determine where to place this new asset in map resources
@@ -450,7 +589,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
 
                     if (ProgramOptions::Verbose && found) {
                         os << "\tAsset " << newAsset.Name << " with type " << newAsset.MapResourceType << " will be added before asset " << placeByExistingAsset.Name << " with type "
-                            << mapResourcesFile->AssetTypes[placeByExistingAsset.AssetTypeIndex] << " to " << mapResourcesChunk->ResourceName.NormalizedFileName << " in "<< resourceContainer.Name << '\n';
+                            << mapResourcesFile->AssetTypes[placeByExistingAsset.AssetTypeIndex] << " to " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in "<< resourceContainer.Name << '\n';
                     }
 
                     MapAsset newMapAsset;
@@ -460,11 +599,11 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
 
                     mapResourcesFile->Assets.insert(mapResourcesFile->Assets.begin() + assetPosition, newMapAsset);
 
-                    os << "\tAdded asset " << newAsset.Name << " with type " << newAsset.MapResourceType << " to " << mapResourcesChunk->ResourceName.NormalizedFileName << " in " << resourceContainer.Name << '\n';
+                    os << "\tAdded asset " << newAsset.Name << " with type " << newAsset.MapResourceType << " to " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in " << resourceContainer.Name << '\n';
                 }
             }
 
-            modFile.FileBytes.resize(0);
+            modFile.FileBytes.clear();
             continue;
         }
         else if (modFile.IsBlangJson) {
@@ -474,20 +613,21 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
 
             chunk = GetChunk(modFile.Name, resourceContainer);
 
-            if (chunk == nullptr) {
-                modFile.FileBytes.resize(0);
+            if (chunk == -1) {
+                modFile.FileBytes.clear();
                 continue;
             }
         }
         else {
-            chunk = GetChunk(modFile.Name, resourceContainer);
+            chunk = modFileChunks[i];
 
-            if (chunk == nullptr) {
-                // This is a new mod, add it to the new mods list
-                resourceContainer.NewModFileList.push_back(modFile);
+            if (chunk == -1) {
+                // This is a new mod, move it to the new mods list
+                resourceContainer.NewModFileList.push_back(std::move(modFile));
+                const ResourceModFile& newModFile = resourceContainer.NewModFileList.back();
 
                 // Get the data to add to mapresources from the resource data file, if available
-                auto x = resourceDataMap.find(CalculateResourceFileNameHash(modFile.Name));
+                auto x = resourceDataMap.find(CalculateResourceFileNameHash(newModFile.Name));
 
                 if (x == resourceDataMap.end()) {
                     continue;
@@ -498,37 +638,40 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                 if (resourceData.MapResourceName.empty()) {
                     if (RemoveWhitespace(resourceData.MapResourceType).empty()) {
                         if (ProgramOptions::Verbose) {
-                            os << "WARNING: " << "Mapresources data for asset " << modFile.Name << " is null, skipping" << '\n';
+                            os << "WARNING: " << "Mapresources data for asset " << newModFile.Name << " is null, skipping" << '\n';
                         }
 
                         continue;
                     }
                     else {
-                        resourceData.MapResourceName = modFile.Name;
+                        resourceData.MapResourceName = newModFile.Name;
                     }
                 }
 
                 // First, find, read and deserialize the .mapresources file in this container
                 // If this is a "gameresources" container, only search for "common.mapresources"
                 if (mapResourcesFile == nullptr && !invalidMapResources) {
-                    for (auto& file : resourceContainer.ChunkList) {
-                        if (EndsWith(file.ResourceName.NormalizedFileName, ".mapresources")) {
-                            if (StartsWith(resourceContainer.Name, "gameresources") && EndsWith(file.ResourceName.NormalizedFileName, "init.mapresources")) {
+                    // The planned data must be in the container before any is read back
+                    writePlannedData();
+
+                    for (size_t file = 0; file < resourceContainer.Chunks.size(); file++) {
+                        if (EndsWith(resourceContainer.GetChunkName(file).NormalizedFileName(), ".mapresources")) {
+                            if (StartsWith(resourceContainer.Name, "gameresources") && EndsWith(resourceContainer.GetChunkName(file).NormalizedFileName(), "init.mapresources")) {
                                 continue;
                             }
 
-                            mapResourcesChunk = &file;
+                            mapResourcesChunk = file;
 
                             // Read the mapresources file data (it should be compressed)
-                            std::vector<std::byte> mapResourcesBytes(mapResourcesChunk->SizeZ);
+                            std::vector<std::byte> mapResourcesBytes(resourceContainer.Chunks.SizesZ[mapResourcesChunk]);
                             uint64_t mapResourcesFileOffset;
 
-                            std::copy(memoryMappedFile.Mem + mapResourcesChunk->FileOffset, memoryMappedFile.Mem + mapResourcesChunk->FileOffset + 8, reinterpret_cast<std::byte*>(&mapResourcesFileOffset));
+                            std::copy(memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[mapResourcesChunk], memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[mapResourcesChunk] + 8, reinterpret_cast<std::byte*>(&mapResourcesFileOffset));
                             std::copy(memoryMappedFile.Mem + mapResourcesFileOffset, memoryMappedFile.Mem + mapResourcesFileOffset + mapResourcesBytes.size(), mapResourcesBytes.begin());
 
                             // Decompress the data
                             try {
-                                originalDecompressedMapResources = Oodle::Decompress(mapResourcesBytes, mapResourcesChunk->Size);
+                                originalDecompressedMapResources = Oodle::Decompress(mapResourcesBytes, resourceContainer.Chunks.Sizes[mapResourcesChunk]);
 
                                 if (originalDecompressedMapResources.empty()) {
                                     throw std::exception();
@@ -539,7 +682,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                             }
                             catch (...) {
                                 invalidMapResources = true;
-                                os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to decompress " << mapResourcesChunk->ResourceName.NormalizedFileName
+                                os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to decompress " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName()
                                     << " - are you trying to add assets in the wrong .resources archive?" << '\n';
                                 break;
                             }
@@ -566,7 +709,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                 if (alreadyExists) {
                     if (ProgramOptions::Verbose) {
                         os << Colors::Red << "WARNING: " << Colors::Reset << "Trying to add asset " << resourceData.MapResourceName
-                            << " that has already been added in " << mapResourcesChunk->ResourceName.NormalizedFileName << ", skipping" << '\n';
+                            << " that has already been added in " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << ", skipping" << '\n';
                     }
 
                     continue;
@@ -588,7 +731,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                     assetTypeIndex = mapResourcesFile->AssetTypes.size() - 1;
 
                     os << "\tAdded asset type " << resourceData.MapResourceType << " to "
-                        << mapResourcesChunk->ResourceName.NormalizedFileName << " in " << resourceContainer.Name << '\n';
+                        << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in " << resourceContainer.Name << '\n';
                 }
 
                 MapAsset newMapAsset;
@@ -598,7 +741,18 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                 mapResourcesFile->Assets.push_back(newMapAsset);
 
                 os << "\tAdded asset " << resourceData.MapResourceName << " with type " << resourceData.MapResourceType
-                    << " to " << mapResourcesChunk->ResourceName.NormalizedFileName << " in " << resourceContainer.Name << '\n';
+                    << " to " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << " in " << resourceContainer.Name << '\n';
+                continue;
+            }
+
+            // Mod files replacing the same chunk are planned once the last one in priority order is reached
+            auto x = chunkCandidates.find(chunk);
+
+            if (x != chunkCandidates.end()) {
+                if (!x->second.empty() && x->second.back() == i) {
+                    planNextCandidate(chunk);
+                }
+
                 continue;
             }
         }
@@ -612,9 +766,12 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
             bool exists = x != blangFileEntries.end();
 
             if (!exists) {
+                // The planned data must be in the container before any is read back
+                writePlannedData();
+
                 uint64_t fileOffset, size;
-                std::copy(memoryMappedFile.Mem + chunk->FileOffset, memoryMappedFile.Mem + chunk->FileOffset + 8, reinterpret_cast<std::byte*>(&fileOffset));
-                std::copy(memoryMappedFile.Mem + chunk->FileOffset + 8, memoryMappedFile.Mem + chunk->FileOffset + 16, reinterpret_cast<std::byte*>(&size));
+                std::copy(memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[chunk], memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[chunk] + 8, reinterpret_cast<std::byte*>(&fileOffset));
+                std::copy(memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[chunk] + 8, memoryMappedFile.Mem + resourceContainer.Chunks.FileOffsets[chunk] + 16, reinterpret_cast<std::byte*>(&size));
 
                 std::vector<std::byte> blangFileBytes(memoryMappedFile.Mem + fileOffset, memoryMappedFile.Mem + fileOffset + size);
                 std::vector<std::byte> decryptedBlangFileBytes = IdCrypt(blangFileBytes, modFile.Name, true);
@@ -625,7 +782,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                 }
 
                 try {
-                    blangFileEntry = BlangFileEntry(BlangFile(decryptedBlangFileBytes), *chunk);
+                    blangFileEntry = BlangFileEntry(BlangFile(decryptedBlangFileBytes), chunk);
                     blangFileEntries[blangFilePath] = blangFileEntry;
                 }
                 catch (...) {
@@ -638,28 +795,46 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                 blangFileEntry.Announce = true;
             }
 
-            // Read the blang JSON and add the strings to the .blang file
-            jsonxx::Object blangJson;
-            jsonxx::Array blangJsonStrings;
+            // Read the blang JSON, unless its strings were parsed when the mod was packaged
+            std::vector<BlangString> modBlangStrings;
 
-            try {
-                std::string blangJsonString(reinterpret_cast<char*>(modFile.FileBytes.data()), modFile.FileBytes.size());
-                blangJson.parse(blangJsonString);
-                blangJsonStrings = blangJson.get<jsonxx::Array>("strings");
+            if (modFile.BlangStrings.has_value()) {
+                modBlangStrings = std::move(*modFile.BlangStrings);
             }
-            catch (...) {
-                os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod/strings/" << fs::path(modFile.Name).replace_extension(".json").string() << '\n';
-                continue;
+            else {
+                try {
+                    if (!modFile.FileBytes.Load()) {
+                        throw std::exception();
+                    }
+
+                    jsonxx::Object blangJson;
+                    std::string blangJsonString(reinterpret_cast<const char*>(modFile.FileBytes.data()), modFile.FileBytes.size());
+                    blangJson.parse(blangJsonString);
+                    jsonxx::Array blangJsonStrings = blangJson.get<jsonxx::Array>("strings");
+
+                    for (size_t i = 0; i < blangJsonStrings.size(); i++) {
+                        jsonxx::Object blangJsonStringObject = blangJsonStrings.get<jsonxx::Object>(i);
+
+                        BlangString modBlangString;
+                        modBlangString.Identifier = blangJsonStringObject.get<jsonxx::String>("name");
+                        modBlangString.Text = blangJsonStringObject.get<jsonxx::String>("text");
+                        modBlangStrings.push_back(modBlangString);
+                    }
+                }
+                catch (...) {
+                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to parse EternalMod/strings/" << fs::path(modFile.Name).replace_extension(".json").string() << '\n';
+                    continue;
+                }
             }
 
-            for (size_t i = 0; i < blangJsonStrings.size(); i++) {
-                jsonxx::Object blangJsonString = blangJsonStrings.get<jsonxx::Object>(i);
+            // Add the strings to the .blang file
+            for (const auto& modBlangString : modBlangStrings) {
                 bool stringFound = false;
 
                 for (auto& blangString : blangFileEntries[blangFilePath].BlangFile.Strings) {
-                    if (blangJsonString.get<jsonxx::String>("name") == blangString.Identifier) {
+                    if (modBlangString.Identifier == blangString.Identifier) {
                         stringFound = true;
-                        blangString.Text = blangJsonString.get<jsonxx::String>("text");
+                        blangString.Text = modBlangString.Text;
 
                         if (modFile.Announce) {
                             os << "\tReplaced " << blangString.Identifier << " in " << modFile.Name << '\n';
@@ -675,12 +850,12 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
                 }
 
                 BlangString newBlangString;
-                newBlangString.Identifier = blangJsonString.get<jsonxx::String>("name");
-                newBlangString.Text = blangJsonString.get<jsonxx::String>("text");
+                newBlangString.Identifier = modBlangString.Identifier;
+                newBlangString.Text = modBlangString.Text;
                 blangFileEntries[blangFilePath].BlangFile.Strings.push_back(newBlangString);
 
                 if (modFile.Announce) {
-                    os << "\tAdded " << blangJsonString.get<jsonxx::String>("name") << " in " << modFile.Name << '\n';
+                    os << "\tAdded " << modBlangString.Identifier << " in " << modFile.Name << '\n';
                 }
 
                 blangFileEntries[blangFilePath].WasModified = true;
@@ -690,63 +865,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
         }
 
         // Replace the mod file data now
-        uint64_t compressedSize = modFile.FileBytes.size();
-        uint64_t uncompressedSize = compressedSize;
-        std::byte compressionMode{0};
-
-        // If this is a texture, check if it's compressed, or compress it if necessary
-        if ((EndsWith(chunk->ResourceName.NormalizedFileName, ".tga") || EndsWith(chunk->ResourceName.NormalizedFileName, ".png")) && compressedSize != 0) {
-            // Check if it's a DIVINITY compressed texture
-            if (std::memcmp(modFile.FileBytes.data(), "DIVINITY", 8) == 0) {
-                // This is a compressed texture, read the uncompressed size
-                std::copy(modFile.FileBytes.begin() + 8, modFile.FileBytes.begin() + 16, reinterpret_cast<std::byte*>(&uncompressedSize));
-
-                // Set the compressed texture data, skipping the DIVINITY header (16 bytes)
-                modFile.FileBytes = std::vector<std::byte>(modFile.FileBytes.begin() + 16, modFile.FileBytes.end());
-                compressedSize = modFile.FileBytes.size();
-                compressionMode = std::byte{2};
-
-                if (ProgramOptions::Verbose) {
-                    os << "\tSuccessfully set compressed texture data for file " << modFile.Name << '\n';
-                }
-            }
-            else if (ProgramOptions::CompressTextures) {
-                // Compress the texture
-                std::vector<std::byte> compressedData;
-
-                try {
-                    compressedData = Oodle::Compress(modFile.FileBytes);
-
-                    if (compressedData.empty()) {
-                        throw std::exception();
-                    }
-                }
-                catch (...) {
-                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to compress " << modFile.Name << '\n';
-                    continue;
-                }
-
-                modFile.FileBytes = compressedData;
-                compressedSize = compressedData.size();
-                compressionMode = std::byte{2};
-
-                if (ProgramOptions::Verbose) {
-                    os << "\tSuccessfully compressed texture file " << modFile.Name << '\n';
-                }
-            }
-        }
-
-        if (!SetModDataForChunk(memoryMappedFile, resourceContainer, *chunk, modFile,
-        compressedSize, uncompressedSize, &compressionMode, buffer, bufferSize)) {
-            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to set new mod data for " << modFile.Name << " in resource chunk." << '\n';
-            continue;
-        }
-
-        if (modFile.Announce) {
-            os << "\tReplaced " << modFile.Name << '\n';
-        }
-
-        fileCount++;
+        planModFile(modFile, chunk);
     }
 
      // Modify the necessary .blang files
@@ -770,12 +889,12 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
             continue;
         }
 
-        ResourceModFile blangModFile(Mod(), blangFileEntry.first, resourceContainer.Name);
-        blangModFile.FileBytes = cryptData;
+        ResourceModFile blangModFile(std::make_shared<Mod>(), blangFileEntry.first, resourceContainer.Name);
+        blangModFile.FileBytes = std::move(cryptData);
         std::byte compressionMode{0};
 
-        if (!SetModDataForChunk(memoryMappedFile, resourceContainer, blangFileEntry.second.Chunk, blangModFile,
-        blangModFile.FileBytes.size(), blangModFile.FileBytes.size(), &compressionMode, buffer, bufferSize)) {
+        if (!SetModDataForChunk(resourceContainer, blangFileEntry.second.Chunk, blangModFile,
+        blangModFile.FileBytes.size(), blangModFile.FileBytes.size(), &compressionMode, writePlan)) {
             os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to set new mod data for " << blangFileEntry.first << "in resource chunk." << '\n';
             continue;
         }
@@ -788,7 +907,7 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
     }
 
     // Modify the map resources file if needed
-    if (mapResourcesFile != nullptr && mapResourcesChunk != nullptr && !originalDecompressedMapResources.empty()) {
+    if (mapResourcesFile != nullptr && mapResourcesChunk != -1 && !originalDecompressedMapResources.empty()) {
         // Serialize the map resources data
         std::vector<std::byte> decompressedMapResourcesData = mapResourcesFile->ToByteVector();
 
@@ -798,23 +917,42 @@ void ReplaceChunks(MemoryMappedFile& memoryMappedFile, ResourceContainer& resour
             std::vector<std::byte> compressedMapResourcesData = Oodle::Compress(decompressedMapResourcesData);
 
             if (compressedMapResourcesData.empty()) {
-                os << "ERROR: " << Colors::Reset << "Failed to compress " << mapResourcesChunk->ResourceName.NormalizedFileName << '\n';
+                os << "ERROR: " << Colors::Reset << "Failed to compress " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << '\n';
             }
             else {
-                ResourceModFile mapResourcesModFile(Mod(), mapResourcesChunk->ResourceName.NormalizedFileName, resourceContainer.Name);
-                mapResourcesModFile.FileBytes = compressedMapResourcesData;
+                ResourceModFile mapResourcesModFile(std::make_shared<Mod>(), std::string(resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName()), resourceContainer.Name);
+                mapResourcesModFile.FileBytes = std::move(compressedMapResourcesData);
 
-                if (!SetModDataForChunk(memoryMappedFile, resourceContainer, *mapResourcesChunk,  mapResourcesModFile, compressedMapResourcesData.size(), decompressedMapResourcesData.size(), nullptr, buffer, bufferSize)) {
-                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to set new mod data for " << mapResourcesChunk->ResourceName.NormalizedFileName << "in resource chunk." << '\n';
+                if (!SetModDataForChunk(resourceContainer, mapResourcesChunk, mapResourcesModFile, mapResourcesModFile.FileBytes.size(), decompressedMapResourcesData.size(), nullptr, writePlan)) {
+                    os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to set new mod data for " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << "in resource chunk." << '\n';
                     return;
                 }
 
-                os << "\tModified " << mapResourcesChunk->ResourceName.NormalizedFileName << '\n';
+                os << "\tModified " << resourceContainer.GetChunkName(mapResourcesChunk).NormalizedFileName() << '\n';
                 fileCount++;
             }
         }
     }
 
+    // Write the planned data
+    writePlannedData();
+
+    // Report the mod files overridden by the one written for each chunk
+    for (auto& chunkCandidate : chunkCandidates) {
+        auto winner = chunkWinners.find(chunkCandidate.first);
+
+        for (size_t candidate : chunkCandidate.second) {
+            ResourceModFile& modFile = resourceContainer.ModFileList[candidate];
+
+            if (winner != chunkWinners.end() && modFile.Announce) {
+                os << Colors::Yellow << "\tSkipped " << Colors::Reset << modFile.Name << " from " << Colors::Yellow << modFile.Parent->Path << Colors::Reset
+                    << ", overridden by " << Colors::Yellow << resourceContainer.ModFileList[winner->second].Parent->Path << Colors::Reset << '\n';
+            }
+
+            modFile.FileBytes.clear();
+        }
+    }
+
     if (fileCount > 0) {
         os << "Number of files replaced: " << Colors::Green << fileCount << " file(s) " << Colors::Reset << "in " << Colors::Yellow << resourceContainer.Path << Colors::Reset << "." << '\n';
     }
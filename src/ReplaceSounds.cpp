@@ -38,7 +38,7 @@ int GetDecodedOpusFileSize(SoundModFile& soundModFile)
         return -1;
     }
 
-    if (fwrite(soundModFile.FileBytes.data(), 1, soundModFile.FileBytes.size(), encFile) != soundModFile.FileBytes.size()) {
+    if (!soundModFile.FileBytes.WriteTo(encFile)) {
         return -1;
     }
 
@@ -85,7 +85,7 @@ bool EncodeSoundMod(SoundModFile& soundModFile)
         return false;
     }
 
-    if (fwrite(soundModFile.FileBytes.data(), 1, soundModFile.FileBytes.size(), decFile) != soundModFile.FileBytes.size()) {
+    if (!soundModFile.FileBytes.WriteTo(decFile)) {
         return false;
     }
 
@@ -102,10 +102,12 @@ bool EncodeSoundMod(SoundModFile& soundModFile)
         return false;
     }
 
+    std::vector<std::byte> encodedBytes;
+
     try {
-        soundModFile.FileBytes.resize(fs::file_size("tmp.opus"));
+        encodedBytes.resize(fs::file_size("tmp.opus"));
 
-        if (soundModFile.FileBytes.size() == 0) {
+        if (encodedBytes.size() == 0) {
             throw std::exception();
         }
 
@@ -121,11 +123,12 @@ bool EncodeSoundMod(SoundModFile& soundModFile)
         return false;
     }
 
-    if (fread(soundModFile.FileBytes.data(), 1, soundModFile.FileBytes.size(), encFile) != soundModFile.FileBytes.size()) {
+    if (fread(encodedBytes.data(), 1, encodedBytes.size(), encFile) != encodedBytes.size()) {
         return false;
     }
 
     fclose(encFile);
+    soundModFile.FileBytes = ModFileBytes(std::move(encodedBytes));
 
     // Remove temp files
     fs::remove("tmp.wav");
@@ -138,7 +141,7 @@ void ReplaceSounds(MemoryMappedFile& memoryMappedFile, SoundContainer& soundCont
 {
     // Sort sound mod file list by priority
     std::stable_sort(soundContainer.ModFileList.begin(), soundContainer.ModFileList.end(),
-        [](const SoundModFile& sound1, const SoundModFile& sound2) { return sound1.Parent.LoadPriority > sound2.Parent.LoadPriority; });
+        [](const SoundModFile& sound1, const SoundModFile& sound2) { return sound1.Parent->LoadPriority > sound2.Parent->LoadPriority; });
 
     size_t fileCount = 0;
 
@@ -256,7 +259,15 @@ void ReplaceSounds(MemoryMappedFile& memoryMappedFile, SoundContainer& soundCont
             return;
         }
 
-        std::copy(soundModFile.FileBytes.begin(), soundModFile.FileBytes.end(), memoryMappedFile.Mem + soundModOffset);
+        // Copy the data straight from where it's stored
+        if (!soundModFile.FileBytes.CopyTo(memoryMappedFile.Mem + soundModOffset)) {
+            memoryMappedFile.ResizeFile(soundModOffset);
+            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to read sound mod file " << soundModFile.Name << " - corrupted?" << '\n';
+            continue;
+        }
+
+        // The data is in the container now, release it
+        soundModFile.FileBytes.clear();
 
         // Replace the sound info for this sound id
         std::vector<SoundEntry> soundEntriesToModify = GetSoundEntriesToModify(soundContainer, soundModId);
@@ -0,0 +1,407 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "ReadChunkInfo.hpp"
+#include "ResourceTocCache.hpp"
+#include "miniz/miniz.h"
+
+namespace fs = std::filesystem;
+
+// Cache layout
+const char TocCacheMagic[8] = { 'E', 'M', 'L', 'T', 'O', 'C', '\0', '\0' };
+
+// Size of the container header holding the offsets of its sections
+const size_t ResourceHeaderSize = 0x7C;
+
+class TocCacheHeader
+{
+public:
+    char Magic[8];
+    uint32_t Version;
+    uint32_t HashCheck;     // Hash of a fixed name, stored hashes are only valid for the same hash function
+    uint64_t EntryCount;
+};
+
+// Entry header, followed by the container's path, names, name positions, chunk table and chunk index
+// The chunks' field positions aren't stored, they follow from the info offset
+// Every part starts 8 bytes aligned
+class TocEntryHeader
+{
+public:
+    uint64_t Size;
+    int64_t WriteTime;
+    uint32_t HeaderCrc;
+    uint32_t PathLength;
+    int32_t FileCount;
+    int32_t TypeCount;
+    int32_t StringsSize;
+    int32_t UnknownCount;
+    uint64_t NamesOffset;
+    uint64_t InfoOffset;
+    uint64_t Dummy7Offset;
+    uint64_t DataOffset;
+    uint64_t IdclOffset;
+    uint64_t NamesOffsetEnd;
+    uint64_t UnknownOffset;
+    uint64_t NamesSize;
+    uint64_t NameCount;
+    uint64_t ChunkCount;
+    uint64_t SlotCount;
+};
+
+static_assert(sizeof(TocCacheHeader) == 24 && sizeof(TocEntryHeader) == 128, "Unexpected cache header layout");
+
+// Name position in the names section
+class StoredName
+{
+public:
+    uint32_t Offset;
+    uint32_t Length;
+};
+
+static size_t Align(const size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// Offsets of an entry's parts, relative to the entry
+class TocEntryLayout
+{
+public:
+    size_t Path;
+    size_t Names;
+    size_t NamePositions;
+    size_t SizesZ;
+    size_t Sizes;
+    size_t NameIds;
+    size_t CompressionModes;
+    size_t Slots;
+    size_t End;
+
+    TocEntryLayout(const TocEntryHeader& header)
+    {
+        Path = sizeof(TocEntryHeader);
+        Names = Path + Align(header.PathLength);
+        NamePositions = Names + Align(header.NamesSize);
+        SizesZ = NamePositions + header.NameCount * sizeof(StoredName);
+        Sizes = SizesZ + header.ChunkCount * 8;
+        NameIds = Sizes + header.ChunkCount * 8;
+        CompressionModes = NameIds + header.ChunkCount * 8;
+        Slots = CompressionModes + Align(header.ChunkCount);
+        End = Slots + header.SlotCount * sizeof(NameIndex::StoredSlot);
+    }
+};
+
+// Identify the container by its size, write time and header checksum
+static bool GetContainerIdentity(const MemoryMappedFile& memoryMappedFile, TocEntryHeader& header)
+{
+    if (memoryMappedFile.Size < ResourceHeaderSize) {
+        return false;
+    }
+
+    std::error_code ec;
+    header.WriteTime = fs::last_write_time(memoryMappedFile.FilePath, ec).time_since_epoch().count();
+
+    if (ec) {
+        return false;
+    }
+
+    header.Size = memoryMappedFile.Size;
+    header.HeaderCrc = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(memoryMappedFile.Mem), ResourceHeaderSize));
+    return true;
+}
+
+ResourceTocCache::ResourceTocCache(const std::string& cachePath) : CachePath(cachePath)
+{
+    // Start with an empty cache if it can't be read
+    try {
+        if (!fs::exists(CachePath)) {
+            return;
+        }
+
+        CacheFile = std::make_shared<MemoryMappedFile>(CachePath, true);
+        const std::byte *data = CacheFile->Mem;
+        size_t size = CacheFile->Size;
+
+        TocCacheHeader cacheHeader;
+
+        if (size < sizeof(TocCacheHeader)) {
+            throw std::exception();
+        }
+
+        std::memcpy(&cacheHeader, data, sizeof(TocCacheHeader));
+
+        if (std::memcmp(cacheHeader.Magic, TocCacheMagic, sizeof(TocCacheMagic)) != 0 || cacheHeader.Version != RESOURCE_TOC_CACHE_VERSION
+        || cacheHeader.HashCheck != NameIndex::Hash("EternalModLoader")) {
+            throw std::exception();
+        }
+
+        // Only find the entries now, they're checked when their container is loaded
+        size_t pos = sizeof(TocCacheHeader);
+
+        for (uint64_t i = 0; i < cacheHeader.EntryCount; i++) {
+            TocEntryHeader header;
+
+            if (sizeof(TocEntryHeader) > size - pos) {
+                throw std::exception();
+            }
+
+            std::memcpy(&header, data + pos, sizeof(TocEntryHeader));
+
+            // Counts past the end of the cache would overflow the layout
+            if (header.PathLength > size || header.NamesSize > size || header.NameCount > size
+            || header.ChunkCount > size || header.SlotCount > size) {
+                throw std::exception();
+            }
+
+            TocEntryLayout layout(header);
+
+            if (layout.End > size - pos) {
+                throw std::exception();
+            }
+
+            Entries[std::string(reinterpret_cast<const char*>(data + pos + layout.Path), header.PathLength)] = pos;
+            pos += layout.End;
+        }
+    }
+    catch (...) {
+        Entries.clear();
+        CacheFile.reset();
+    }
+}
+
+// Fill the container's table of contents from its cache entry, if the container is unchanged
+bool ResourceTocCache::Load(const MemoryMappedFile& memoryMappedFile, ResourceContainer& resourceContainer)
+{
+    auto entry = Entries.find(resourceContainer.Path);
+    TocEntryHeader identity;
+
+    if (entry == Entries.end() || !GetContainerIdentity(memoryMappedFile, identity)) {
+        return false;
+    }
+
+    const std::byte *entryData = CacheFile->Mem + entry->second;
+    TocEntryHeader header;
+    std::memcpy(&header, entryData, sizeof(TocEntryHeader));
+
+    if (header.Size != identity.Size || header.WriteTime != identity.WriteTime || header.HeaderCrc != identity.HeaderCrc) {
+        return false;
+    }
+
+    TocEntryLayout layout(header);
+
+    // View the names in the cache, they're at the same positions as in the container's names section
+    auto storedNames = reinterpret_cast<const StoredName*>(entryData + layout.NamePositions);
+    auto namesData = reinterpret_cast<const char*>(entryData + layout.Names);
+    std::vector<ResourceName> namesList(header.NameCount);
+
+    for (size_t i = 0; i < namesList.size(); i++) {
+        if (storedNames[i].Offset > header.NamesSize || storedNames[i].Length > header.NamesSize - storedNames[i].Offset) {
+            return false;
+        }
+
+        namesList[i] = ResourceName(std::string_view(namesData + storedNames[i].Offset, storedNames[i].Length));
+    }
+
+    // The chunk fields are read and written in the container's file info records,
+    // so the records must be the container's own and all of them must be in it
+    uint32_t fileCount;
+    uint64_t infoOffset;
+    std::memcpy(&fileCount, memoryMappedFile.Mem + 0x20, 4);
+    std::memcpy(&infoOffset, memoryMappedFile.Mem + 0x50, 8);
+
+    if (header.ChunkCount != fileCount || header.InfoOffset != infoOffset || infoOffset > memoryMappedFile.Size
+    || fileCount > (memoryMappedFile.Size - infoOffset) / sizeof(ResourceFileInfo)) {
+        return false;
+    }
+
+    // Copy the chunk table, it's changed while mods are injected
+    ChunkTable& chunks = resourceContainer.Chunks;
+    auto nameIds = reinterpret_cast<const uint64_t*>(entryData + layout.NameIds);
+    chunks.resize(header.ChunkCount);
+
+    for (size_t i = 0; i < header.ChunkCount; i++) {
+        if (nameIds[i] >= header.NameCount) {
+            return false;
+        }
+
+        chunks.FileOffsets[i] = GetChunkFileOffset(header.InfoOffset, i);
+        chunks.NameIds[i] = nameIds[i];
+    }
+
+    std::memcpy(chunks.SizesZ.data(), entryData + layout.SizesZ, header.ChunkCount * 8);
+    std::memcpy(chunks.Sizes.data(), entryData + layout.Sizes, header.ChunkCount * 8);
+    std::memcpy(chunks.CompressionModes.data(), entryData + layout.CompressionModes, header.ChunkCount);
+
+    // Probe the stored chunk index in place, its slots are only checked when they're found
+    auto storedSlots = reinterpret_cast<const NameIndex::StoredSlot*>(entryData + layout.Slots);
+
+    if (!resourceContainer.ChunkIndex.Load(CacheFile, storedSlots, header.SlotCount, header.ChunkCount, namesData, header.NamesSize)) {
+        return false;
+    }
+
+    // Assign all values to resource
+    resourceContainer.FileCount = header.FileCount;
+    resourceContainer.TypeCount = header.TypeCount;
+    resourceContainer.StringsSize = header.StringsSize;
+    resourceContainer.NamesOffset = header.NamesOffset;
+    resourceContainer.InfoOffset = header.InfoOffset;
+    resourceContainer.Dummy7Offset = header.Dummy7Offset;
+    resourceContainer.DataOffset = header.DataOffset;
+    resourceContainer.IdclOffset = header.IdclOffset;
+    resourceContainer.UnknownCount = header.UnknownCount;
+    resourceContainer.FileCount2 = header.FileCount * 2;
+    resourceContainer.NamesOffsetEnd = header.NamesOffsetEnd;
+    resourceContainer.UnknownOffset = header.UnknownOffset;
+    resourceContainer.UnknownOffset2 = header.UnknownOffset;
+    resourceContainer.NamesData = std::shared_ptr<const char[]>(CacheFile, namesData);
+    resourceContainer.NamesList = std::move(namesList);
+    return true;
+}
+
+// Keep a container's freshly read table of contents for the next run, before any mods are injected
+void ResourceTocCache::Store(const MemoryMappedFile& memoryMappedFile, const ResourceContainer& resourceContainer)
+{
+    TocEntryHeader header;
+
+    if (!GetContainerIdentity(memoryMappedFile, header)) {
+        return;
+    }
+
+    const ChunkTable& chunks = resourceContainer.Chunks;
+    header.PathLength = resourceContainer.Path.size();
+    header.FileCount = resourceContainer.FileCount;
+    header.TypeCount = resourceContainer.TypeCount;
+    header.StringsSize = resourceContainer.StringsSize;
+    header.UnknownCount = resourceContainer.UnknownCount;
+    header.NamesOffset = resourceContainer.NamesOffset;
+    header.InfoOffset = resourceContainer.InfoOffset;
+    header.Dummy7Offset = resourceContainer.Dummy7Offset;
+    header.DataOffset = resourceContainer.DataOffset;
+    header.IdclOffset = resourceContainer.IdclOffset;
+    header.NamesOffsetEnd = resourceContainer.NamesOffsetEnd;
+    header.UnknownOffset = resourceContainer.UnknownOffset;
+    header.NamesSize = resourceContainer.UnknownOffset - resourceContainer.NamesOffsetEnd;
+    header.NameCount = resourceContainer.NamesList.size();
+    header.ChunkCount = chunks.size();
+
+    const char *namesData = resourceContainer.NamesData.get();
+    std::vector<NameIndex::StoredSlot> storedSlots = resourceContainer.ChunkIndex.Store(namesData);
+    header.SlotCount = storedSlots.size();
+
+    TocEntryLayout layout(header);
+    std::vector<std::byte> entry(layout.End);
+    std::memcpy(entry.data(), &header, sizeof(TocEntryHeader));
+    std::memcpy(entry.data() + layout.Path, resourceContainer.Path.data(), header.PathLength);
+    std::memcpy(entry.data() + layout.Names, namesData, header.NamesSize);
+
+    auto storedNames = reinterpret_cast<StoredName*>(entry.data() + layout.NamePositions);
+
+    for (size_t i = 0; i < resourceContainer.NamesList.size(); i++) {
+        const std::string_view name = resourceContainer.NamesList[i].FullFileName;
+        storedNames[i] = StoredName{static_cast<uint32_t>(name.data() - namesData), static_cast<uint32_t>(name.size())};
+    }
+
+    std::memcpy(entry.data() + layout.SizesZ, chunks.SizesZ.data(), header.ChunkCount * 8);
+    std::memcpy(entry.data() + layout.Sizes, chunks.Sizes.data(), header.ChunkCount * 8);
+    std::copy(chunks.NameIds.begin(), chunks.NameIds.end(), reinterpret_cast<uint64_t*>(entry.data() + layout.NameIds));
+    std::memcpy(entry.data() + layout.CompressionModes, chunks.CompressionModes.data(), header.ChunkCount);
+    std::memcpy(entry.data() + layout.Slots, storedSlots.data(), storedSlots.size() * sizeof(NameIndex::StoredSlot));
+
+    std::lock_guard<std::mutex> lock(Mutex);
+    NewEntries[resourceContainer.Path] = std::move(entry);
+}
+
+bool ResourceTocCache::Save()
+{
+    // Drop the entries of containers that don't exist anymore
+    std::vector<std::string> removedContainers;
+
+    for (const auto& entry : Entries) {
+        std::error_code ec;
+
+        if (!fs::exists(entry.first, ec) && NewEntries.find(entry.first) == NewEntries.end()) {
+            removedContainers.push_back(entry.first);
+        }
+    }
+
+    // Only rewrite the cache if a container was added, changed or removed
+    if (NewEntries.empty() && removedContainers.empty()) {
+        return true;
+    }
+
+    for (const auto& removedContainer : removedContainers) {
+        Entries.erase(removedContainer);
+    }
+
+    for (const auto& newEntry : NewEntries) {
+        Entries.erase(newEntry.first);
+    }
+
+    // Write to a temporary file first, so an interrupted write can't leave a broken cache behind
+    std::string tempCachePath = CachePath + ".tmp";
+    FILE *cacheFile = fopen(tempCachePath.c_str(), "wb");
+
+    if (cacheFile == nullptr) {
+        return false;
+    }
+
+    TocCacheHeader cacheHeader;
+    std::memcpy(cacheHeader.Magic, TocCacheMagic, sizeof(TocCacheMagic));
+    cacheHeader.Version = RESOURCE_TOC_CACHE_VERSION;
+    cacheHeader.HashCheck = NameIndex::Hash("EternalModLoader");
+    cacheHeader.EntryCount = Entries.size() + NewEntries.size();
+
+    bool failed = fwrite(&cacheHeader, 1, sizeof(TocCacheHeader), cacheFile) != sizeof(TocCacheHeader);
+
+    // Copy the kept entries from the old cache as they are
+    for (const auto& entry : Entries) {
+        TocEntryHeader header;
+        std::memcpy(&header, CacheFile->Mem + entry.second, sizeof(TocEntryHeader));
+        size_t entrySize = TocEntryLayout(header).End;
+        failed |= fwrite(CacheFile->Mem + entry.second, 1, entrySize, cacheFile) != entrySize;
+    }
+
+    for (const auto& newEntry : NewEntries) {
+        failed |= fwrite(newEntry.second.data(), 1, newEntry.second.size(), cacheFile) != newEntry.second.size();
+    }
+
+    failed |= fclose(cacheFile) != 0;
+
+    // The old cache can't be replaced while it's mapped on Windows, so the containers viewing it must be gone too
+    Entries.clear();
+    CacheFile.reset();
+
+    std::error_code ec;
+
+    if (!failed) {
+        fs::rename(tempCachePath, CachePath, ec);
+        failed = static_cast<bool>(ec);
+    }
+
+    if (failed) {
+        fs::remove(tempCachePath, ec);
+        return false;
+    }
+
+    return true;
+}
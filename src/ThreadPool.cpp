@@ -0,0 +1,281 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ThreadPool.hpp"
+
+// Pool and queue owned by the current thread, if it's a worker
+static thread_local ThreadPool *CurrentPool{nullptr};
+static thread_local size_t CurrentQueueIndex{0};
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    // Create one queue per worker, then start the workers
+    Queues.reserve(threadCount);
+
+    for (size_t i = 0; i < threadCount; i++) {
+        Queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    Threads.reserve(threadCount);
+
+    for (size_t i = 0; i < threadCount; i++) {
+        Threads.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    // Finish the remaining tasks and stop the workers
+    {
+        std::lock_guard<std::mutex> lock(StateMutex);
+        Stopping = true;
+    }
+
+    TaskAvailable.notify_all();
+
+    for (auto& thread : Threads) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::GetDefaultThreadCount()
+{
+    size_t threadCount = std::thread::hardware_concurrency();
+    return threadCount == 0 ? 4 : threadCount;
+}
+
+void ThreadPool::Submit(std::function<void()> task, TaskGroup *group)
+{
+    // Workers push to their own queue, other threads distribute tasks round-robin
+    size_t queueIndex = CurrentPool == this ? CurrentQueueIndex : NextQueue++ % Queues.size();
+
+    PendingTasks++;
+    QueuedTasks++;
+
+    if (group != nullptr) {
+        group->PendingTasks++;
+        group->QueuedTasks++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(Queues[queueIndex]->Mutex);
+        Queues[queueIndex]->Tasks.push_back(Task{std::move(task), group});
+    }
+
+    // Threads waiting on a group help with queued tasks too, so they're woken up as well,
+    // otherwise workers all waiting on their groups could sleep through the tasks those groups need
+    {
+        std::lock_guard<std::mutex> lock(StateMutex);
+        TasksFinished.notify_all();
+    }
+
+    TaskAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    Task task;
+
+    // Help with the queued tasks, then wait for the running ones
+    while (PendingTasks > 0) {
+        if (TakeTask(task)) {
+            RunTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(StateMutex);
+        TasksFinished.wait(lock, [this] { return PendingTasks == 0 || QueuedTasks > 0; });
+    }
+
+    // Rethrow the first exception thrown by a task, if any
+    std::lock_guard<std::mutex> lock(StateMutex);
+
+    if (FirstException != nullptr) {
+        std::exception_ptr exception = FirstException;
+        FirstException = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::Wait(TaskGroup& group)
+{
+    Task task;
+
+    // Help with the group's queued tasks until it's done, so waiting from a worker can't deadlock
+    // Other tasks are left alone, a task picked up here could block on something the caller holds
+    while (group.PendingTasks > 0) {
+        if (TakeGroupTask(group, task)) {
+            RunTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(StateMutex);
+        TasksFinished.wait(lock, [&group] { return group.PendingTasks == 0 || group.QueuedTasks > 0; });
+    }
+
+    // Rethrow the first exception thrown by a task in the group, if any
+    std::lock_guard<std::mutex> lock(StateMutex);
+
+    if (group.FirstException != nullptr) {
+        std::exception_ptr exception = group.FirstException;
+        group.FirstException = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+bool ThreadPool::PopTask(size_t queueIndex, Task& task)
+{
+    // Take the newest task from our own queue
+    std::lock_guard<std::mutex> lock(Queues[queueIndex]->Mutex);
+
+    if (Queues[queueIndex]->Tasks.empty()) {
+        return false;
+    }
+
+    task = std::move(Queues[queueIndex]->Tasks.back());
+    Queues[queueIndex]->Tasks.pop_back();
+    QueuedTasks--;
+
+    if (task.Group != nullptr) {
+        task.Group->QueuedTasks--;
+    }
+
+    return true;
+}
+
+bool ThreadPool::StealTask(size_t queueIndex, Task& task)
+{
+    // Take the oldest task from any other queue
+    for (size_t i = 1; i <= Queues.size(); i++) {
+        size_t victimIndex = (queueIndex + i) % Queues.size();
+
+        if (victimIndex == queueIndex) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(Queues[victimIndex]->Mutex);
+
+        if (Queues[victimIndex]->Tasks.empty()) {
+            continue;
+        }
+
+        task = std::move(Queues[victimIndex]->Tasks.front());
+        Queues[victimIndex]->Tasks.pop_front();
+        QueuedTasks--;
+
+        if (task.Group != nullptr) {
+            task.Group->QueuedTasks--;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool ThreadPool::TakeTask(Task& task)
+{
+    // Workers check their own queue first, other threads can only steal
+    if (CurrentPool == this) {
+        return PopTask(CurrentQueueIndex, task) || StealTask(CurrentQueueIndex, task);
+    }
+
+    return StealTask(Queues.size(), task);
+}
+
+bool ThreadPool::TakeGroupTask(TaskGroup& group, Task& task)
+{
+    if (group.QueuedTasks == 0) {
+        return false;
+    }
+
+    // Take the group's newest task, starting with our own queue, where the group's tasks were likely submitted
+    size_t firstQueue = CurrentPool == this ? CurrentQueueIndex : 0;
+
+    for (size_t i = 0; i < Queues.size(); i++) {
+        WorkerQueue& queue = *Queues[(firstQueue + i) % Queues.size()];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+
+        for (auto it = queue.Tasks.rbegin(); it != queue.Tasks.rend(); it++) {
+            if (it->Group != &group) {
+                continue;
+            }
+
+            task = std::move(*it);
+            queue.Tasks.erase(std::next(it).base());
+            QueuedTasks--;
+            group.QueuedTasks--;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::RunTask(Task& task)
+{
+    try {
+        task.Function();
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(StateMutex);
+        std::exception_ptr& firstException = task.Group != nullptr ? task.Group->FirstException : FirstException;
+
+        if (firstException == nullptr) {
+            firstException = std::current_exception();
+        }
+    }
+
+    task.Function = nullptr;
+
+    // Wake up waiting threads once a group or everything is done
+    bool groupFinished = task.Group != nullptr && --task.Group->PendingTasks == 0;
+
+    if (--PendingTasks == 0 || groupFinished) {
+        std::lock_guard<std::mutex> lock(StateMutex);
+        TasksFinished.notify_all();
+    }
+}
+
+void ThreadPool::WorkerLoop(size_t queueIndex)
+{
+    CurrentPool = this;
+    CurrentQueueIndex = queueIndex;
+
+    Task task;
+
+    while (true) {
+        if (TakeTask(task)) {
+            RunTask(task);
+            continue;
+        }
+
+        // Sleep until there's more work, or the pool is being destroyed
+        std::unique_lock<std::mutex> lock(StateMutex);
+        TaskAvailable.wait(lock, [this] { return Stopping || QueuedTasks > 0; });
+
+        if (Stopping && QueuedTasks == 0) {
+            break;
+        }
+    }
+}
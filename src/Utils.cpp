@@ -17,18 +17,8 @@
 */
 
 #include <algorithm>
-#include <filesystem>
 #include "Utils.hpp"
 
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#else
-#include <sys/statvfs.h>
-#endif
-
-namespace fs = std::filesystem;
-
 std::string RemoveWhitespace(const std::string& stringWithWhitespace)
 {
     std::string stringWithoutWhitespace = stringWithWhitespace;
@@ -62,7 +52,7 @@ std::vector<std::string> SplitString(std::string stringToSplit, const char delim
     return resultVector;
 }
 
-bool EndsWith(const std::string& fullString, const std::string& suffix)
+bool EndsWith(const std::string_view fullString, const std::string_view suffix)
 {
     if (fullString.length() >= suffix.length()) {
         return 0 == fullString.compare(fullString.length() - suffix.length(), suffix.length(), suffix);
@@ -72,40 +62,24 @@ bool EndsWith(const std::string& fullString, const std::string& suffix)
     }
 }
 
-bool StartsWith(const std::string& fullString, const std::string& prefix)
+bool StartsWith(const std::string_view fullString, const std::string_view prefix)
 {
     return 0 == fullString.rfind(prefix, 0);
 }
 
-std::string NormalizeResourceFilename(std::string filename)
+std::string_view NormalizeResourceFilename(std::string_view filename)
 {
-    if (filename.find_first_of('$') != std::string::npos) {
+    if (filename.find_first_of('$') != std::string_view::npos) {
         filename = filename.substr(0, filename.find_first_of('$'));
     }
 
-    if (filename.find_last_of('#') != std::string::npos) {
+    if (filename.find_last_of('#') != std::string_view::npos) {
         filename = filename.substr(0, filename.find_last_of('#'));
     }
 
-    if (filename.find_first_of('#') != std::string::npos) {
+    if (filename.find_first_of('#') != std::string_view::npos) {
         filename = filename.substr(filename.find_first_of('#'));
     }
 
     return filename;
 }
-
-int GetClusterSize()
-{
-#ifdef _WIN32
-    DWORD sectorsPerCluster;
-    DWORD bytesPerSector;
-    DWORD numberOfFreeClusters;
-    DWORD totalNumberOfClusters;
-    bool result = GetDiskFreeSpaceA(nullptr, &sectorsPerCluster, &bytesPerSector, &numberOfFreeClusters, &totalNumberOfClusters);
-
-    return result ? sectorsPerCluster * bytesPerSector : -1;
-#else
-    struct statvfs diskInfo;
-    return statvfs(fs::current_path().c_str(), &diskInfo) == 0 ? diskInfo.f_bsize : -1;
-#endif
-}
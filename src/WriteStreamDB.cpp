@@ -68,13 +68,13 @@ void BuildStreamDBIndex(StreamDBContainer& streamDBContainer, std::stringstream&
 
     // Sort mod file list by priority
     std::stable_sort(streamDBContainer.ModFiles.begin(), streamDBContainer.ModFiles.end(),
-        [](const StreamDBModFile& streamDbModFile1, const StreamDBModFile& streamDbModFile2) { return streamDbModFile1.Parent.LoadPriority > streamDbModFile2.Parent.LoadPriority; });
+        [](const StreamDBModFile& streamDbModFile1, const StreamDBModFile& streamDbModFile2) { return streamDbModFile1.Parent->LoadPriority > streamDbModFile2.Parent->LoadPriority; });
 
     // Remove mods with duplicate FileId.
     std::vector<StreamDBModFile> buffer;
     buffer.reserve(streamDBContainer.ModFiles.size());
 
-    for (const auto& streamDBModFile : streamDBContainer.ModFiles) {
+    for (auto& streamDBModFile : streamDBContainer.ModFiles) {
         bool found = false;
 
         // Check if buffer already has this file id
@@ -83,39 +83,67 @@ void BuildStreamDBIndex(StreamDBContainer& streamDBContainer, std::stringstream&
                 found = true;
 
                 // Keep the one with bigger priority
-                if (buffer[i].Parent.LoadPriority >= streamDBModFile.Parent.LoadPriority) {
-                    buffer[i] = streamDBModFile;
+                if (buffer[i].Parent->LoadPriority >= streamDBModFile.Parent->LoadPriority) {
+                    buffer[i] = std::move(streamDBModFile);
                 }
+
+                break;
             }
         }
 
         if (!found) {
             // Add the streamdb mod file
-            buffer.push_back(streamDBModFile);
+            buffer.push_back(std::move(streamDBModFile));
         }
     }
 
     // Set mod file list to filtered buffer
-    streamDBContainer.ModFiles = buffer;
+    streamDBContainer.ModFiles = std::move(buffer);
 
     // Read the streamdb mod header
     for (auto& streamDBMod : streamDBContainer.ModFiles) {
-        // Check for STREAMDB magic
-        if (std::memcmp(streamDBMod.FileData.data(), "STREAMDB", 8) != 0) {
+        std::byte header[12];
+        unsigned int lodCount = 0;
+        std::vector<std::byte> lodInfo;
+
+        // Check for STREAMDB magic, and that the LOD info after it is all there
+        bool hasHeader = streamDBMod.FileData.Peek(header, sizeof(header)) && std::memcmp(header, "STREAMDB", 8) == 0;
+
+        if (hasHeader) {
+            std::memcpy(&lodCount, header + 8, 4);
+            hasHeader = lodCount <= (streamDBMod.FileData.size() - sizeof(header)) / 8;
+        }
+
+        if (hasHeader) {
+            lodInfo.resize(sizeof(header) + lodCount * 8);
+            hasHeader = streamDBMod.FileData.Peek(lodInfo.data(), lodInfo.size());
+        }
+
+        if (!hasHeader) {
             os << Colors::Red << "WARNING: " << Colors::Reset << "streamdb mod \"" << streamDBMod.Name << "\" is missing a required header. Skipping...\n";
             continue;
         }
 
         // Read LOD info
-        size_t offset = 8;
-        streamDBMod.LODcount = *reinterpret_cast<unsigned int*>((streamDBMod.FileData.data() + offset));
-        offset += 4;
+        bool isLODDataInFile = true;
 
-        for (int i = 0; i < streamDBMod.LODcount; i++) {
-            streamDBMod.LODDataOffset.push_back(*reinterpret_cast<unsigned int*>((streamDBMod.FileData.data() + offset)));
-            streamDBMod.LODDataLength.push_back(*reinterpret_cast<unsigned int*>((streamDBMod.FileData.data() + offset + 4)));
-            offset += 8;
+        for (unsigned int i = 0; i < lodCount; i++) {
+            unsigned int lodDataOffset, lodDataLength;
+            std::memcpy(&lodDataOffset, lodInfo.data() + sizeof(header) + i * 8, 4);
+            std::memcpy(&lodDataLength, lodInfo.data() + sizeof(header) + i * 8 + 4, 4);
+            isLODDataInFile = isLODDataInFile && static_cast<uint64_t>(lodDataOffset) + lodDataLength <= streamDBMod.FileData.size();
+
+            streamDBMod.LODDataOffset.push_back(lodDataOffset);
+            streamDBMod.LODDataLength.push_back(lodDataLength);
+        }
+
+        // The LOD data is written straight from the mod file later, so it has to be in it
+        if (!isLODDataInFile) {
+            os << Colors::Red << "WARNING: " << Colors::Reset << "streamdb mod \"" << streamDBMod.Name << "\" has LOD data past its end. Skipping...\n";
+            continue;
         }
+
+        streamDBMod.LODcount = lodCount;
     }
 
     // Remove mods with missing LODCount - this means we couldn't read STREAMDB header
@@ -126,28 +154,19 @@ void BuildStreamDBIndex(StreamDBContainer& streamDBContainer, std::stringstream&
         return;
     }
 
-    // Copy the filedata we need for each LOD
-    for (auto& streamDBMod : streamDBContainer.ModFiles) {
-        for (int i = 0; i < streamDBMod.LODcount; i++) {
-            int lodDataOffset = streamDBMod.LODDataOffset[i];
-            int lodDataLength = streamDBMod.LODDataLength[i];
-
-            std::vector<std::byte> lodData(streamDBMod.FileData.data() + lodDataOffset, streamDBMod.FileData.data() + lodDataOffset + lodDataLength);
-            streamDBMod.LODFileData.push_back(lodData);
-        }
-    }
-
     // Sort mod file list by FileId
     std::stable_sort(streamDBContainer.ModFiles.begin(), streamDBContainer.ModFiles.end(),
         [](const StreamDBModFile& streamDbModFile1, const StreamDBModFile& streamDbModFile2) { return streamDbModFile1.FileId < streamDbModFile2.FileId; });
 
     // Build the streamdb index in numerical order by FileId
+    // The entries point into the mod files, which stay where they are from now on
     for (auto& streamDBMod : streamDBContainer.ModFiles) {
         for (int i = 0; i < streamDBMod.LODcount; i++) {
             uint64_t fileId = streamDBMod.FileId + i;
 
-            StreamDBEntry streamDBEntry(fileId, 0, streamDBMod.LODDataLength[i], streamDBMod.Name, streamDBMod.LODFileData[i]);
-            streamDBContainer.StreamDBEntries.push_back(streamDBEntry);
+            StreamDBEntry streamDBEntry(fileId, 0, streamDBMod.LODDataLength[i], streamDBMod.Name,
+                &streamDBMod.FileData, static_cast<unsigned int>(streamDBMod.LODDataOffset[i]));
+            streamDBContainer.StreamDBEntries.push_back(std::move(streamDBEntry));
         }
     }
 
@@ -172,8 +191,8 @@ void BuildStreamDBIndex(StreamDBContainer& streamDBContainer, std::stringstream&
     }
 }
 
-void WriteStreamDBFile(FILE *streamDBFile, const StreamDBContainer& streamDBContainer,
-    std::vector<StreamDBContainer>& streamDBContainerList, std::stringstream& os)
+// Write the streamdb file, returning false if it's corrupt and has to be discarded
+bool WriteStreamDBFile(FILE *streamDBFile, const StreamDBContainer& streamDBContainer, std::stringstream& os)
 {
     int fileCount = 0;
 
@@ -207,23 +226,21 @@ void WriteStreamDBFile(FILE *streamDBFile, const StreamDBContainer& streamDBCont
         size_t offsetDiff = desiredOffset - ftell(streamDBFile);
 
         // If the offsetDiff is outside this range, we have a corrupt StreamDBEntries table and need to abort
-        if (offsetDiff < 0 || offsetDiff > 15) {
-            fclose(streamDBFile);
-            std::error_code ec;
-            fs::remove(streamDBContainer.Path, ec);
-            streamDBContainerList.erase(std::find_if(streamDBContainerList.begin(), streamDBContainerList.end(),
-                [&](const StreamDBContainer& streamDBContainer2) { return streamDBContainer2.Name == streamDBContainer.Name; }));
-
-            os << Colors::Red << "ERROR: " << Colors::Reset << "Failed to build \"" << streamDBContainer.Name << "\" file.\n";
-            break;
-        }
+        bool isWritten = offsetDiff <= 15;
+
+        if (isWritten) {
+            // Write null padding
+            std::vector<std::byte> padding(offsetDiff, std::byte{0});
+            fwrite(padding.data(), 1, offsetDiff, streamDBFile);
 
-        // Write null padding
-        std::vector<std::byte> padding(offsetDiff, std::byte{0});
-        fwrite(padding.data(), 1, offsetDiff, streamDBFile);
+            // Write mod file data, straight from the mod file
+            isWritten = streamDBEntry.FileData->WriteTo(streamDBFile, streamDBEntry.FileDataOffset, streamDBEntry.DataLength);
+        }
 
-        // Write mod file data
-        fwrite(streamDBEntry.FileData.data(), 1, streamDBEntry.FileData.size(), streamDBFile);
+        // The file can't be used if the data can't be written either
+        if (!isWritten) {
+            return false;
+        }
 
         os << "\tAdded streamdb mod file with id " << streamDBEntry.FileId << " [" << streamDBEntry.Name << "]\n";
         fileCount++;
@@ -237,4 +254,6 @@ void WriteStreamDBFile(FILE *streamDBFile, const StreamDBContainer& streamDBCont
     if (ProgramOptions::SlowMode) {
         os.flush();
     }
+
+    return true;
 }
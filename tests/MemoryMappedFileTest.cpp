@@ -0,0 +1,122 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "MemoryMappedFile.hpp"
+
+namespace fs = std::filesystem;
+
+// Whether the page holding the address is still mapped
+static bool IsMapped(const std::byte *address)
+{
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    auto page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) / pageSize * pageSize);
+    unsigned char residency;
+
+    return mincore(page, pageSize, &residency) == 0 || errno != ENOMEM;
+}
+
+// Shrinking the file must unmap the range past its new end, and growing it again must map and keep the data
+static bool TestShrinkThenGrow(const std::string& filePath)
+{
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    std::vector<char> fileData(pageSize * 8);
+
+    for (size_t i = 0; i < fileData.size(); i++) {
+        fileData[i] = static_cast<char>(i % 251);
+    }
+
+    std::ofstream(filePath, std::ios::binary).write(fileData.data(), fileData.size());
+
+    MemoryMappedFile memoryMappedFile(filePath);
+
+    // Grow first, so the mapping is larger than the file
+    if (!memoryMappedFile.ResizeFile(pageSize * 9)) {
+        std::cout << "Failed to grow the file" << std::endl;
+        return false;
+    }
+
+    size_t shrunkSize = pageSize * 2 + 10;
+
+    if (!memoryMappedFile.ResizeFile(shrunkSize)) {
+        std::cout << "Failed to shrink the file" << std::endl;
+        return false;
+    }
+
+    if (fs::file_size(filePath) != shrunkSize || IsMapped(memoryMappedFile.Mem + pageSize * 4)) {
+        std::cout << "Range past the end of the shrunk file is still mapped" << std::endl;
+        return false;
+    }
+
+    if (std::memcmp(memoryMappedFile.Mem, fileData.data(), shrunkSize) != 0) {
+        std::cout << "Shrinking changed the data kept in the file" << std::endl;
+        return false;
+    }
+
+    size_t grownSize = pageSize * 6;
+
+    if (!memoryMappedFile.ResizeFile(grownSize)) {
+        std::cout << "Failed to grow the shrunk file" << std::endl;
+        return false;
+    }
+
+    // The new range reads as zeroes and can be written up to the last byte
+    for (size_t i = shrunkSize; i < grownSize; i++) {
+        if (memoryMappedFile.Mem[i] != std::byte{0}) {
+            std::cout << "Grown range isn't zeroed" << std::endl;
+            return false;
+        }
+    }
+
+    std::memset(memoryMappedFile.Mem + shrunkSize, 0x7F, grownSize - shrunkSize);
+
+    if (std::memcmp(memoryMappedFile.Mem, fileData.data(), shrunkSize) != 0) {
+        std::cout << "Growing changed the data kept in the file" << std::endl;
+        return false;
+    }
+
+    memoryMappedFile.UnmapFile();
+
+    if (fs::file_size(filePath) != grownSize) {
+        std::cout << "Grown file has the wrong size" << std::endl;
+        return false;
+    }
+
+    std::vector<char> grownData(grownSize);
+    std::ifstream(filePath, std::ios::binary).read(grownData.data(), grownSize);
+
+    return std::memcmp(grownData.data(), fileData.data(), shrunkSize) == 0 && grownData[grownSize - 1] == 0x7F;
+}
+
+int main()
+{
+    std::string filePath = (fs::temp_directory_path() / ("MemoryMappedFileTest" + std::to_string(getpid()) + ".bin")).string();
+    bool passed = TestShrinkThenGrow(filePath);
+    fs::remove(filePath);
+
+    return passed ? 0 : 1;
+}
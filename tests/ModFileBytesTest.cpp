@@ -0,0 +1,148 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "ModFileBytes.hpp"
+#include "miniz/miniz.h"
+
+namespace fs = std::filesystem;
+
+// A zip entry's data, as the mod loader views it in the mapped archive
+static ModFileBytes GetEntryBytes(mz_zip_archive& zip, const std::shared_ptr<MemoryMappedFile>& archive, const char *name)
+{
+    mz_zip_archive_file_stat stat;
+    mz_zip_reader_file_stat(&zip, mz_zip_reader_locate_file(&zip, name, nullptr, 0), &stat);
+
+    uint16_t fileNameLength, extraFieldLength;
+    std::memcpy(&fileNameLength, archive->Mem + stat.m_local_header_ofs + 26, 2);
+    std::memcpy(&extraFieldLength, archive->Mem + stat.m_local_header_ofs + 28, 2);
+    size_t dataOffset = stat.m_local_header_ofs + 30 + fileNameLength + extraFieldLength;
+
+    if (stat.m_method == 0) {
+        return ModFileBytes(archive, dataOffset, stat.m_uncomp_size);
+    }
+
+    return ModFileBytes(archive, dataOffset, stat.m_comp_size, stat.m_uncomp_size, stat.m_crc32);
+}
+
+// Every payload path writes each byte once, and only bytes already in memory are copied, once
+static bool TestPayloadsCopiedAtMostOnce(const fs::path& directory)
+{
+    std::vector<std::byte> storedData(5000), deflatedData(70000), looseData(3000);
+
+    for (size_t i = 0; i < deflatedData.size(); i++) {
+        deflatedData[i] = static_cast<std::byte>(i % 7);
+    }
+
+    for (size_t i = 0; i < storedData.size(); i++) {
+        storedData[i] = static_cast<std::byte>(i * 13 % 251);
+    }
+
+    for (size_t i = 0; i < looseData.size(); i++) {
+        looseData[i] = static_cast<std::byte>(i % 256);
+    }
+
+    // A small mod zip, with a stored resource file and a deflated streamdb file
+    std::string zipPath = (directory / "mod.zip").string();
+    std::string loosePath = (directory / "loose.bin").string();
+    mz_zip_archive zip{};
+
+    mz_zip_writer_init_file(&zip, zipPath.c_str(), 0);
+    mz_zip_writer_add_mem(&zip, "gameresources/stored.decl", storedData.data(), storedData.size(), MZ_NO_COMPRESSION);
+    mz_zip_writer_add_mem(&zip, "streamdb/foo_id#1000.streamdb", deflatedData.data(), deflatedData.size(), MZ_BEST_COMPRESSION);
+    mz_zip_writer_finalize_archive(&zip);
+    mz_zip_writer_end(&zip);
+
+    std::ofstream(loosePath, std::ios::binary).write(reinterpret_cast<const char*>(looseData.data()), looseData.size());
+
+    auto archive = std::make_shared<MemoryMappedFile>(zipPath, true);
+    zip = mz_zip_archive{};
+    mz_zip_reader_init_mem(&zip, archive->Mem, archive->Size, 0);
+
+    ModFileBytes storedBytes = GetEntryBytes(zip, archive, "gameresources/stored.decl");
+    ModFileBytes deflatedBytes = GetEntryBytes(zip, archive, "streamdb/foo_id#1000.streamdb");
+    ModFileBytes looseBytes(loosePath, looseData.size());
+    ModFileBytes ownedBytes(storedData);
+    mz_zip_reader_end(&zip);
+
+    if (storedBytes.IsDeferred() || !deflatedBytes.IsDeferred()) {
+        std::cout << "Zip entries weren't stored and deflated" << std::endl;
+        return false;
+    }
+
+    // Resource and sound data is copied into the container, streamdb data is written in LOD ranges
+    ModFileBytes::InjectedBytes = 0;
+    ModFileBytes::CopiedBytes = 0;
+
+    std::vector<std::byte> container(storedData.size() + looseData.size() + storedData.size());
+    std::string streamDBPath = (directory / "EternalMod.streamdb").string();
+    FILE *streamDBFile = fopen(streamDBPath.c_str(), "wb");
+
+    bool success = deflatedBytes.Verify() && storedBytes.CopyTo(container.data())
+        && looseBytes.CopyTo(container.data() + storedData.size())
+        && ownedBytes.CopyTo(container.data() + storedData.size() + looseData.size())
+        && deflatedBytes.WriteTo(streamDBFile, 0, 1000) && deflatedBytes.WriteTo(streamDBFile, 1000, deflatedData.size() - 1000);
+
+    fclose(streamDBFile);
+
+    if (!success) {
+        std::cout << "Failed to write the mod file data" << std::endl;
+        return false;
+    }
+
+    std::vector<std::byte> streamDBData(fs::file_size(streamDBPath));
+    std::ifstream(streamDBPath, std::ios::binary).read(reinterpret_cast<char*>(streamDBData.data()), streamDBData.size());
+
+    if (std::memcmp(container.data(), storedData.data(), storedData.size()) != 0
+    || std::memcmp(container.data() + storedData.size(), looseData.data(), looseData.size()) != 0
+    || std::memcmp(container.data() + storedData.size() + looseData.size(), storedData.data(), storedData.size()) != 0
+    || streamDBData != deflatedData) {
+        std::cout << "Written data doesn't match the mod files" << std::endl;
+        return false;
+    }
+
+    uint64_t payloadSize = storedData.size() + deflatedData.size() + looseData.size() + storedData.size();
+    uint64_t inMemorySize = storedData.size() * 2;
+
+    if (ModFileBytes::InjectedBytes != payloadSize || ModFileBytes::CopiedBytes != inMemorySize) {
+        std::cout << "Injected " << ModFileBytes::InjectedBytes << " bytes, " << ModFileBytes::CopiedBytes << " of them copied, expected "
+            << payloadSize << " and " << inMemorySize << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    fs::path directory = fs::temp_directory_path() / "ModFileBytesTest";
+    fs::create_directories(directory);
+
+    bool passed = TestPayloadsCopiedAtMostOnce(directory);
+    fs::remove_all(directory);
+
+    return passed ? 0 : 1;
+}
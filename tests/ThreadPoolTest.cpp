@@ -0,0 +1,104 @@
+/*
+* This file is part of EternalModLoaderCpp (https://github.com/PowerBall253/EternalModLoaderCpp).
+* Copyright (C) 2021 PowerBall253
+*
+* EternalModLoaderCpp is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* EternalModLoaderCpp is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with EternalModLoaderCpp. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include "ThreadPool.hpp"
+
+// Every worker submits subtasks and waits on them, while the subtasks submit and wait on their own
+static bool TestNestedWait(size_t threadCount)
+{
+    ThreadPool threadPool(threadCount);
+    std::atomic<size_t> leafCount{0};
+
+    for (size_t i = 0; i < threadCount * 4; i++) {
+        threadPool.Submit([&] {
+            TaskGroup group;
+
+            for (size_t j = 0; j < 8; j++) {
+                threadPool.Submit([&] {
+                    TaskGroup subGroup;
+
+                    for (size_t k = 0; k < 8; k++) {
+                        threadPool.Submit([&] { leafCount++; }, &subGroup);
+                    }
+
+                    threadPool.Wait(subGroup);
+                }, &group);
+            }
+
+            threadPool.Wait(group);
+        });
+    }
+
+    threadPool.Wait();
+    return leafCount == threadCount * 4 * 8 * 8;
+}
+
+// A worker already asleep waiting on a group must wake up for a group task queued on a busy worker
+static bool TestWaitWakesUpForQueuedTask()
+{
+    ThreadPool threadPool(2);
+    TaskGroup group;
+    std::promise<void> subtaskRan;
+    std::promise<void> waitFinished;
+
+    // Queued round-robin, so the first worker runs the producer and the second one the waiter
+    threadPool.Submit([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        threadPool.Submit([&] { subtaskRan.set_value(); }, &group);
+        subtaskRan.get_future().wait();
+    }, &group);
+
+    threadPool.Submit([&] {
+        threadPool.Wait(group);
+        waitFinished.set_value();
+    });
+
+    // Don't help from this thread, the waiting worker has to run the subtask
+    if (waitFinished.get_future().wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+        std::cout << "Worker waiting on a group didn't wake up for a queued task" << std::endl;
+        std::_Exit(1);
+    }
+
+    threadPool.Wait();
+    return true;
+}
+
+int main()
+{
+    if (!TestWaitWakesUpForQueuedTask()) {
+        return 1;
+    }
+
+    for (size_t threadCount : { 1, 2, 4, 8 }) {
+        for (int run = 0; run < 50; run++) {
+            if (!TestNestedWait(threadCount)) {
+                std::cout << "Nested wait failed with " << threadCount << " threads" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}